@@ -68,6 +68,12 @@ class Analysis : private boost::noncopyable {
     analysis_time_ += time;
   }
 
+  /// Clears the warnings and time of the previous run of the analysis.
+  void ResetAnalysis() {
+    analysis_time_ = 0;
+    warnings_.clear();
+  }
+
  private:
   Settings settings_;  ///< All settings for analysis.
   double analysis_time_;  ///< Time taken by the analysis.
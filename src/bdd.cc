@@ -20,15 +20,39 @@
 
 #include "bdd.h"
 
+#include <map>
+#include <unordered_set>
+
 #include <boost/multiprecision/miller_rabin.hpp>
 #include <boost/range/algorithm.hpp>
 
 #include "ext/find_iterator.h"
+#include "ext/parallel.h"
 #include "logger.h"
 #include "zbdd.h"
 
 namespace scram::core {
 
+namespace {
+
+const int kMinReorderSize = 256;  ///< Smaller functions are not reordered.
+
+/// Counts the if-then-else vertices of a function graph
+/// without descending into modules.
+///
+/// @param[in] vertex  The root vertex of the function graph.
+/// @param[in,out] ids  The ids of the counted vertices.
+///
+/// @returns The number of new vertices in the graph.
+int CountVertices(const Bdd::VertexPtr& vertex, std::unordered_set<int>* ids) {
+  if (vertex->terminal() || !ids->insert(vertex->id()).second)
+    return 0;
+  const Ite& ite = Ite::Ref(vertex);
+  return 1 + CountVertices(ite.high(), ids) + CountVertices(ite.low(), ids);
+}
+
+}  // namespace
+
 int GetPrimeNumber(int n) {
   assert(n > 0 && "Only natural numbers.");
   if (n % 2 == 0)
@@ -41,9 +65,14 @@ int GetPrimeNumber(int n) {
 Bdd::Bdd(const Pdag* graph, const Settings& settings)
     : kSettings_(settings),
       coherent_(graph->coherent()),
+      pool_(VertexPool<Ite>::Create()),
       kOne_(new Terminal<Ite>(true)),
-      function_id_(2) {
+      function_id_(2),
+      reorder_threshold_(kMinReorderSize) {
   TIMER(DEBUG3, "Converting PDAG into BDD");
+  if (kSettings_.reorder_time() > 0)
+    reorder_budget_ =
+        std::make_shared<ReorderBudget>(kSettings_.reorder_time());
   if (graph->IsTrivial()) {
     const Gate& top_gate = graph->root();
     assert(top_gate.args().size() == 1);
@@ -69,6 +98,10 @@ Bdd::Bdd(const Pdag* graph, const Settings& settings)
   LOG(DEBUG4) << "# of entries in unique table: " << unique_table_.size();
   LOG(DEBUG4) << "# of entries in AND table: " << and_table_.size();
   LOG(DEBUG4) << "# of entries in OR table: " << or_table_.size();
+  LOG(DEBUG4) << "# of BDD vertex allocations: " << pool_->stats().allocations
+              << " (reused: " << pool_->stats().reuses
+              << ", peak live: " << pool_->stats().max_live
+              << ", slabs: " << pool_->stats().slabs << ")";
   ClearMarks(false);
   LOG(DEBUG4) << "# of ITE in BDD: " << CountIteNodes(root_.vertex);
   ClearMarks(false);
@@ -79,10 +112,64 @@ Bdd::Bdd(const Pdag* graph, const Settings& settings)
   }
 }
 
+Bdd::Bdd(const Settings& settings)
+    : kSettings_(settings),
+      coherent_(false),
+      pool_(VertexPool<Ite>::Create()),
+      kOne_(new Terminal<Ite>(true)),
+      function_id_(2),
+      reorder_threshold_(kMinReorderSize) {}
+
+Bdd::Bdd(const Gate& module, const Settings& settings,
+         std::shared_ptr<ReorderBudget> reorder_budget)
+    : Bdd(Settings(settings).jobs(1)) {
+  assert(module.module() && "Only modules are converted separately.");
+  reorder_budget_ = std::move(reorder_budget);
+  coherent_ = module.coherent();
+  std::unordered_map<int, std::pair<Function, int>> gates;
+  ConvertGraph(module, &gates);
+  Freeze();
+}
+
+Bdd::Bdd(const Bdd& bdd, const Function& function, const Settings& settings)
+    : Bdd(settings) {
+  coherent_ = bdd.coherent_;
+  index_to_order_ = bdd.index_to_order_;
+  std::unordered_map<int, VertexPtr> clones;
+  root_ = {function.complement, Import(function.vertex, &clones)};
+  // The modules are discovered in the deterministic traversal order.
+  std::vector<int> modules;
+  std::unordered_set<int> visited;  // The vertex ids in the source BDD.
+  auto gather = [&modules, &visited](auto& self,
+                                     const VertexPtr& vertex) -> void {
+    if (vertex->terminal() || !visited.insert(vertex->id()).second)
+      return;
+    const Ite& ite = Ite::Ref(vertex);
+    if (ite.module())
+      modules.push_back(ite.index());
+    self(self, ite.high());
+    self(self, ite.low());
+  };
+  gather(gather, function.vertex);
+  for (int i = 0; i < modules.size(); ++i) {
+    if (modules_.count(modules[i]))
+      continue;
+    const Function& module = bdd.modules_.find(modules[i])->second;
+    modules_.emplace(modules[i], Function{module.complement,
+                                          Import(module.vertex, &clones)});
+    gather(gather, module.vertex);
+  }
+  if (coherent_) {
+    Freeze();
+  } else {
+    ClearTables();
+  }
+}
+
 Bdd::~Bdd() noexcept = default;
 
 void Bdd::Analyze(const Pdag* graph) noexcept {
-  zbdd_ = std::make_unique<Zbdd>(this, kSettings_);
+  zbdd_ = std::make_unique<Zbdd>(this, kSettings_, graph);
   zbdd_->Analyze(graph);
   if (!coherent_)  // The BDD has been used by the ZBDD.
     Freeze();
@@ -97,7 +184,7 @@ ItePtr Bdd::FindOrAddVertex(int index, const VertexPtr& high,
   if (!in_table.expired())
     return in_table.lock();
   assert(order > 0 && "Improper order.");
-  ItePtr ite(new Ite(index, order, function_id_++, high, low));
+  ItePtr ite(new (pool_.get()) Ite(index, order, function_id_++, high, low));
   ite->complement_edge(complement_edge);
   in_table = ite;
   return ite;
@@ -153,12 +240,16 @@ Bdd::Function Bdd::ConvertGraph(
                                         arg.second.order())});
     index_to_order_.emplace(arg.second.index(), arg.second.order());
   }
+  if (kSettings_.jobs() > 1)
+    ConvertModules(gate);
   for (const Gate::ConstArg<Gate>& arg : gate.args<Gate>()) {
-    Function res = ConvertGraph(arg.second, gates);
     if (arg.second.module()) {
+      if (!modules_.count(arg.second.index()))
+        ConvertGraph(arg.second, gates);
       args.push_back(
           {arg.first < 0, FindOrAddVertex(arg.second, kOne_, kOne_, true)});
     } else {
+      Function res = ConvertGraph(arg.second, gates);
       bool complement = (arg.first < 0) ^ res.complement;
       args.push_back({complement, res.vertex});
     }
@@ -177,13 +268,57 @@ Bdd::Function Bdd::ConvertGraph(
   }
   ClearTables();
   assert(result.vertex);
-  if (gate.module())
+  if (gate.module()) {
+    args.clear();  // The reordering needs the only references.
+    Reorder(&result);
     modules_.emplace(gate.index(), result);
-  if (gate.parents().size() > 1)
+  }
+  // The modules are memoized for all their parents in the module table.
+  if (gate.parents().size() > 1 && !gate.module())
     gates->insert({gate.index(), {result, 1}});
   return result;
 }
 
+void Bdd::ConvertModules(const Gate& gate) noexcept {
+  std::vector<const Gate*> modules;
+  for (const Gate::ConstArg<Gate>& arg : gate.args<Gate>()) {
+    if (arg.second.module() && !modules_.count(arg.second.index()))
+      modules.push_back(&arg.second);
+  }
+  if (modules.size() < 2)
+    return;
+  std::vector<std::unique_ptr<Bdd>> workers(modules.size());
+  ext::parallel_for(kSettings_.jobs(), modules.size(), [&](int i) {
+    workers[i].reset(new Bdd(*modules[i], kSettings_, reorder_budget_));
+  });
+  // The import order is fixed for the reproducible vertex ids.
+  for (const std::unique_ptr<Bdd>& worker : workers) {
+    std::unordered_map<int, VertexPtr> clones;
+    for (const std::pair<const int, Function>& module : worker->modules_) {
+      modules_.emplace(module.first,
+                       Function{module.second.complement,
+                                Import(module.second.vertex, &clones)});
+    }
+    index_to_order_.insert(worker->index_to_order_.begin(),
+                           worker->index_to_order_.end());
+  }
+}
+
+Bdd::VertexPtr Bdd::Import(
+    const VertexPtr& vertex,
+    std::unordered_map<int, VertexPtr>* clones) noexcept {
+  if (vertex->terminal())
+    return kOne_;
+  VertexPtr& clone = (*clones)[vertex->id()];
+  if (clone)
+    return clone;
+  ItePtr ite = Ite::Ptr(vertex);
+  VertexPtr high = Import(ite->high(), clones);
+  VertexPtr low = Import(ite->low(), clones);
+  clone = FindOrAddVertex(ite, high, low, ite->complement_edge());
+  return clone;
+}
+
 std::pair<int, int> Bdd::GetMinMaxId(const VertexPtr& arg_one,
                                      const VertexPtr& arg_two,
                                      bool complement_one,
@@ -313,6 +448,132 @@ Bdd::Function Bdd::CalculateConsensus(const ItePtr& ite,
                      ite->complement_edge() ^ complement);
 }
 
+void Bdd::Reorder(Function* function) noexcept {
+  if (!reorder_budget_ || reorder_budget_->exhausted() ||
+      function->vertex->terminal()) {
+    return;
+  }
+  std::unordered_set<int> ids;
+  int best_size = CountVertices(function->vertex, &ids);
+  if (best_size < reorder_threshold_)
+    return;
+  CLOCK(reorder_time);
+  LOG(DEBUG4) << "Reordering BDD variables of a function with " << best_size
+              << " vertices...";
+  std::map<int, int> levels;  // The order to index mapping of variables.
+  std::vector<VertexPtr> stack = {function->vertex};
+  ids.clear();
+  while (!stack.empty()) {
+    VertexPtr vertex = std::move(stack.back());
+    stack.pop_back();
+    if (vertex->terminal() || !ids.insert(vertex->id()).second)
+      continue;
+    const Ite& ite = Ite::Ref(vertex);
+    assert((!levels.count(ite.order()) ||
+            levels.at(ite.order()) == ite.index()) &&
+           "Non-unique variable orders.");
+    if (!ite.module())  // The modules must stay above their variables.
+      levels.emplace(ite.order(), ite.index());
+    stack.push_back(ite.high());
+    stack.push_back(ite.low());
+  }
+  if (levels.size() < 2)
+    return;
+  std::vector<int> orders;  // The available orders in the ascending order.
+  std::vector<int> indices;  // The variable at each order.
+  for (const std::pair<const int, int>& level : levels) {
+    orders.push_back(level.first);
+    indices.push_back(level.second);
+  }
+  ReorderBudget::Timer timer(reorder_budget_.get());
+  auto rebuild = [&function, &orders, &indices, &timer](Bdd* bdd) {
+    std::unordered_map<int, int> index_to_order;
+    for (int i = 0; i < indices.size(); ++i)
+      index_to_order.emplace(indices[i], orders[i]);
+    std::unordered_map<int, Function> results;
+    Function result =
+        bdd->Rebuild(function->vertex, index_to_order, &timer, &results);
+    result.complement ^= function->complement;
+    return result;
+  };
+
+  std::unique_ptr<Bdd> best_bdd;  // The holder of the best function.
+  Function best_function;
+  int original_size = best_size;
+  for (bool improved = true; improved && timer();) {
+    improved = false;
+    for (int i = 0; i < indices.size() - 1 && timer(); ++i) {
+      std::swap(indices[i], indices[i + 1]);
+      std::unique_ptr<Bdd> bdd(new Bdd(kSettings_));
+      Function candidate = rebuild(bdd.get());
+      if (!candidate) {  // Out of time in the middle of the rebuild.
+        std::swap(indices[i], indices[i + 1]);
+        break;
+      }
+      ids.clear();
+      int size = CountVertices(candidate.vertex, &ids);
+      if (size < best_size) {
+        best_size = size;
+        best_function = candidate;
+        best_bdd = std::move(bdd);
+        improved = true;
+      } else {
+        std::swap(indices[i], indices[i + 1]);  // Revert.
+      }
+    }
+  }
+  if (best_bdd) {
+    *function = {};  // Frees the original vertices with the old orders.
+    std::unordered_map<int, VertexPtr> clones;
+    *function = {best_function.complement,
+                 Import(best_function.vertex, &clones)};
+    for (int i = 0; i < indices.size(); ++i) {
+      if (auto it = index_to_order_.find(indices[i]);
+          it != index_to_order_.end()) {
+        it->second = orders[i];
+      }
+    }
+  }
+  reorder_threshold_ = std::max(reorder_threshold_, 2 * best_size);
+  LOG(DEBUG4) << "Reordered BDD variables from " << original_size << " to "
+              << best_size << " vertices in " << DUR(reorder_time);
+}
+
+Bdd::Function Bdd::Rebuild(
+    const VertexPtr& vertex, const std::unordered_map<int, int>& orders,
+    ReorderBudget::Timer* timer,
+    std::unordered_map<int, Function>* results) noexcept {
+  if (vertex->terminal())
+    return {false, kOne_};
+  if (auto it = results->find(vertex->id()); it != results->end())
+    return it->second;
+  if (!(*timer)())
+    return {};
+  ItePtr ite = Ite::Ptr(vertex);
+  int order = ite->module() ? ite->order() : orders.find(ite->index())->second;
+  ItePtr var = FindOrAddVertex(ite->index(), kOne_, kOne_, true, order);
+  if (var->unique()) {
+    var->module(ite->module());
+    var->coherent(ite->coherent());
+  }
+  Function high = Rebuild(ite->high(), orders, timer, results);
+  if (!high)
+    return {};
+  Function low = Rebuild(ite->low(), orders, timer, results);
+  if (!low)
+    return {};
+  low.complement ^= ite->complement_edge();
+  // The Shannon expansion: (var & high) | (~var & low).
+  Function then_part =
+      Apply<kAnd>(var, high.vertex, /*complement_one=*/false, high.complement);
+  Function else_part =
+      Apply<kAnd>(var, low.vertex, /*complement_one=*/true, low.complement);
+  Function result = Apply<kOr>(then_part.vertex, else_part.vertex,
+                               then_part.complement, else_part.complement);
+  results->emplace(vertex->id(), result);
+  return result;
+}
+
 int Bdd::CountIteNodes(const VertexPtr& vertex) noexcept {
   if (vertex->terminal())
     return 0;
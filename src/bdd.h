@@ -21,10 +21,15 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
+#include <cstdlib>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <forward_list>
 #include <memory>
+#include <new>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -221,6 +226,120 @@ class Terminal : public Vertex<T>, public IntrusivePtrCast<T, Terminal<T>> {
   bool value() const { return Vertex<T>::id(); }
 };
 
+/// Memory pool for non-terminal vertices of a single BDD manager.
+/// Vertices are carved out of large aligned slabs
+/// and recycled through a free list upon deletion.
+/// The slab header points back to the pool,
+/// so the vertices find their pool without any per-vertex storage.
+///
+/// The pool outlives its manager while any of its vertices are alive,
+/// and all the slabs are released at once with the last vertex.
+///
+/// @tparam T  The type of non-terminal vertices.
+///
+/// @pre Vertices of the same pool are not used concurrently.
+template <class T>
+class VertexPool : private boost::noncopyable {
+  /// Detaches the pool from its manager.
+  struct Releaser {
+    /// Deletes the pool if no vertices are left.
+    ///
+    /// @param[in] pool  The pool owned by the manager.
+    void operator()(VertexPool* pool) const noexcept {
+      pool->orphan_ = true;
+      if (!pool->live_)
+        delete pool;
+    }
+  };
+
+ public:
+  /// The pool owned by the manager.
+  using Handle = std::unique_ptr<VertexPool, Releaser>;
+
+  /// Allocation statistics of the pool.
+  struct Stats {
+    std::int64_t allocations = 0;  ///< The total number of allocations.
+    std::int64_t reuses = 0;  ///< The allocations from the free list.
+    std::int64_t max_live = 0;  ///< The peak number of live vertices.
+    int slabs = 0;  ///< The number of allocated slabs.
+  };
+
+  /// @returns A new pool for a manager.
+  static Handle Create() { return Handle(new VertexPool); }
+
+  /// @returns The allocation statistics.
+  const Stats& stats() const { return stats_; }
+
+  /// @returns Memory for a new vertex.
+  ///
+  /// @throws std::bad_alloc  Memory for a new slab is not available.
+  void* Allocate() {
+    if (++live_ > stats_.max_live)
+      stats_.max_live = live_;
+    ++stats_.allocations;
+    if (free_list_) {
+      ++stats_.reuses;
+      void* ptr = free_list_;
+      free_list_ = *static_cast<void**>(ptr);
+      return ptr;
+    }
+    if (next_ == end_)
+      AddSlab();
+    void* ptr = next_;
+    next_ += kVertexSize;
+    return ptr;
+  }
+
+  /// Returns the memory of a deleted vertex to its pool.
+  ///
+  /// @param[in] ptr  The memory allocated by any pool of this type.
+  static void Deallocate(void* ptr) noexcept {
+    auto slab = reinterpret_cast<std::uintptr_t>(ptr) & ~(kSlabSize - 1);
+    VertexPool* pool = *reinterpret_cast<VertexPool**>(slab);
+    *static_cast<void**>(ptr) = pool->free_list_;
+    pool->free_list_ = ptr;
+    if (--pool->live_ == 0 && pool->orphan_)
+      delete pool;
+  }
+
+ private:
+  static constexpr std::uintptr_t kSlabSize = 1 << 15;  ///< Power of 2.
+  /// The slab header with the pool pointer.
+  static constexpr std::size_t kHeaderSize = alignof(std::max_align_t);
+  /// The vertex size rounded up to keep all the vertices aligned.
+  static constexpr std::size_t kVertexSize =
+      (sizeof(T) + alignof(T) - 1) / alignof(T) * alignof(T);
+  static_assert(kHeaderSize % alignof(T) == 0);
+  static_assert(kVertexSize >= sizeof(void*));
+
+  VertexPool() = default;
+
+  ~VertexPool() noexcept {
+    for (void* slab : slabs_)
+      std::free(slab);
+  }
+
+  /// Allocates a new slab for vertices.
+  void AddSlab() {
+    void* slab = std::aligned_alloc(kSlabSize, kSlabSize);
+    if (!slab)
+      throw std::bad_alloc();
+    slabs_.push_back(slab);
+    ++stats_.slabs;
+    *static_cast<VertexPool**>(slab) = this;
+    next_ = static_cast<char*>(slab) + kHeaderSize;
+    end_ = next_ + (kSlabSize - kHeaderSize) / kVertexSize * kVertexSize;
+  }
+
+  std::vector<void*> slabs_;  ///< The allocated slabs.
+  char* next_ = nullptr;  ///< The next unused memory in the last slab.
+  char* end_ = nullptr;  ///< The end of the usable memory in the last slab.
+  void* free_list_ = nullptr;  ///< The memory of deleted vertices.
+  std::int64_t live_ = 0;  ///< The number of live vertices.
+  bool orphan_ = false;  ///< The manager is gone.
+  Stats stats_;  ///< The allocation statistics.
+};
+
 /// Representation of non-terminal vertices in BDD graphs.
 /// This class is a base class for various BDD-specific vertices.
 /// however, as Vertex, NonTerminal is not polymorphic.
@@ -263,6 +382,29 @@ class NonTerminal : public Vertex<T>, public IntrusivePtrCast<T> {
         coherent_(false),
         mark_(false) {}
 
+  /// Allocates vertices in the memory pool of their manager.
+  ///
+  /// @param[in] size  The size of the vertex.
+  /// @param[in] pool  The pool of the manager.
+  ///
+  /// @returns Memory for the vertex.
+  static void* operator new(std::size_t size, VertexPool<T>* pool) {
+    assert(size == sizeof(T) && "Only the main vertex type is pooled.");
+    return pool->Allocate();
+  }
+
+  /// Returns the memory of the vertex to its pool.
+  ///
+  /// @param[in] ptr  The memory of the vertex.
+  /// @{
+  static void operator delete(void* ptr) noexcept {
+    VertexPool<T>::Deallocate(ptr);
+  }
+  static void operator delete(void* ptr, VertexPool<T>*) noexcept {
+    VertexPool<T>::Deallocate(ptr);
+  }
+  /// @}
+
   /// @returns The index of this vertex.
   int index() const { return index_; }
 
@@ -345,26 +487,8 @@ class Ite : public NonTerminal<Ite> {
   /// @param[in] flag  Indicator to treat the low branch as a complement.
   void complement_edge(bool flag) { complement_edge_ = flag; }
 
-  /// @returns The probability of the function graph.
-  double p() const { return p_; }
-
-  /// Sets the probability of the function graph.
-  ///
-  /// @param[in] value  Calculated value for the probability.
-  void p(double value) { p_ = value; }
-
-  /// @returns Saved results of importance factor calculations.
-  double factor() const { return factor_; }
-
-  /// Memorized results of importance factor calculations.
-  ///
-  /// @param[in] value  Calculation results for importance factor.
-  void factor(double value) { factor_ = value; }
-
  private:
   bool complement_edge_ = false;  ///< Flag for complement edge.
-  double p_ = 0;  ///< Probability of the function graph.
-  double factor_ = 0;  ///< Importance factor calculation results.
 };
 
 using ItePtr = IntrusivePtr<Ite>;  ///< Shared if-then-else vertices.
@@ -681,6 +805,50 @@ class CacheTable {
 
 class Zbdd;  // For analysis purposes.
 
+/// The time limit of BDD variable reordering
+/// shared by a BDD and its concurrent module conversions.
+/// The time is charged incrementally by the reordering in progress,
+/// so the limit holds for the total time of all the threads.
+class ReorderBudget {
+ public:
+  using Clock = std::chrono::steady_clock;  ///< The time source.
+
+  /// Charger of the time spent by a single reordering.
+  class Timer {
+   public:
+    /// @param[in] budget  The budget to charge.
+    explicit Timer(ReorderBudget* budget) noexcept
+        : budget_(budget), last_(Clock::now()) {}
+
+    /// Charges the time since the last call.
+    ///
+    /// @returns true if the budget is not exhausted.
+    bool operator()() noexcept {
+      Clock::time_point now = Clock::now();
+      Clock::rep spent = (budget_->spent_ += (now - last_).count());
+      last_ = now;
+      return spent < budget_->limit_;
+    }
+
+   private:
+    ReorderBudget* budget_;  ///< The charged budget.
+    Clock::time_point last_;  ///< The time of the last charge.
+  };
+
+  /// @param[in] seconds  The total time limit in seconds.
+  explicit ReorderBudget(double seconds) noexcept
+      : limit_(std::chrono::duration_cast<Clock::duration>(
+                   std::chrono::duration<double>(seconds))
+                   .count()) {}
+
+  /// @returns true if no more time is left for reordering.
+  bool exhausted() const noexcept { return spent_ >= limit_; }
+
+ private:
+  const Clock::rep limit_;  ///< The time limit in clock ticks.
+  std::atomic<Clock::rep> spent_ = 0;  ///< The time spent in clock ticks.
+};
+
 /// Analysis of PDAGs with Binary Decision Diagrams.
 /// This binary decision diagram data structure
 /// represents Reduced Ordered BDD with attributed edges.
@@ -737,6 +905,17 @@ class Bdd : private boost::noncopyable {
   /// @note BDD construction may take considerable time.
   Bdd(const Pdag* graph, const Settings& settings);
 
+  /// Copies a function of another BDD
+  /// together with the modules it depends upon
+  /// into a standalone BDD for the analysis of the function.
+  ///
+  /// @param[in] bdd  The source BDD constructed from a PDAG.
+  /// @param[in] function  The function of the source BDD.
+  /// @param[in] settings  The analysis settings.
+  ///
+  /// @note The variable orders and coherence are inherited from the source.
+  Bdd(const Bdd& bdd, const Function& function, const Settings& settings);
+
   /// To handle incomplete ZBDD type with unique pointers.
   ~Bdd() noexcept;
 
@@ -764,6 +943,15 @@ class Bdd : private boost::noncopyable {
   ///          this function will not help with the mess.
   void ClearMarks(bool mark) { ClearMarks(root_.vertex, mark); }
 
+  /// @returns The number of if-then-else vertices in the BDD
+  ///          including the vertices of modules.
+  int CountIteNodes() noexcept {
+    ClearMarks(false);
+    int num_vertices = CountIteNodes(root_.vertex);
+    ClearMarks(false);
+    return num_vertices;
+  }
+
   /// Runs the Qualitative analysis
   /// with the representation of a PDAG as ROBDD.
   ///
@@ -782,6 +970,22 @@ class Bdd : private boost::noncopyable {
   using IteWeakPtr = WeakIntrusivePtr<Ite>;  ///< Pointer in containers.
   using ComputeTable = CacheTable<Function>;  ///< Computation results.
 
+  /// Constructs an empty BDD for intermediate functions.
+  ///
+  /// @param[in] settings  The analysis settings.
+  explicit Bdd(const Settings& settings);
+
+  /// Constructs a private BDD of a module
+  /// for concurrent conversion of the PDAG.
+  ///
+  /// @param[in] module  The module gate in the preprocessed PDAG.
+  /// @param[in] settings  The analysis settings.
+  /// @param[in] reorder_budget  The reordering time limit of the main BDD.
+  ///
+  /// @post The BDD only contains the module functions (no root function).
+  Bdd(const Gate& module, const Settings& settings,
+      std::shared_ptr<ReorderBudget> reorder_budget);
+
   /// Finds or adds a unique if-then-else vertex in BDD.
   /// All vertices in the BDD must be created with this functions.
   /// Otherwise, the BDD may not be reduced.
@@ -842,6 +1046,65 @@ class Bdd : private boost::noncopyable {
       const Gate& gate,
       std::unordered_map<int, std::pair<Function, int>>* gates) noexcept;
 
+  /// Converts argument modules of a gate concurrently
+  /// with private BDDs
+  /// and imports the resulting module functions into this BDD.
+  ///
+  /// Modules don't share variables or gates with the rest of the graph;
+  /// thus, the private BDDs share no vertices or tables,
+  /// and the conversion needs no synchronization.
+  ///
+  /// @param[in] gate  The parent gate of the argument modules.
+  ///
+  /// @post Already converted modules are left as is.
+  void ConvertModules(const Gate& gate) noexcept;
+
+  /// Copies a function graph of another BDD into this BDD.
+  ///
+  /// @param[in] vertex  The root vertex of the function graph.
+  /// @param[in,out] clones  The mapping of the other BDD vertex ids
+  ///                        to the copies in this BDD.
+  ///
+  /// @returns The copy of the root vertex in this BDD.
+  VertexPtr Import(const VertexPtr& vertex,
+                   std::unordered_map<int, VertexPtr>* clones) noexcept;
+
+  /// Reorders the variables of a finished module function
+  /// if the function has outgrown the reordering threshold.
+  /// The intermediate results of the construction are not reordered.
+  /// The adjacent variables are swapped one pair at a time,
+  /// and every candidate order is rebuilt in a scratch BDD,
+  /// while the number of vertices shrinks
+  /// and the reordering time limit permits.
+  /// The rebuilding is abandoned as soon as the time limit is exceeded.
+  ///
+  /// The variables of a module don't appear outside of the module function;
+  /// thus, the orders are permuted only among the variables of the function.
+  /// The sub-module proxies keep their orders
+  /// above the variables of the sub-modules.
+  ///
+  /// @param[in,out] function  The function of the module.
+  ///
+  /// @pre The function holds the only references to its vertices.
+  ///
+  /// @post The function is equivalent to the original one
+  ///       with the same modules and complement edges.
+  void Reorder(Function* function) noexcept;
+
+  /// Rebuilds a function graph of another BDD with new variable orders.
+  ///
+  /// @param[in] vertex  The root vertex of the function graph.
+  /// @param[in] orders  The new orders of the variables mapped by indices.
+  /// @param[in,out] timer  The charger of the reordering time limit.
+  /// @param[in,out] results  Memoization of the rebuilt vertices.
+  ///
+  /// @returns The rebuilt function of the vertex in this BDD.
+  /// @returns An uninitialized function if the time limit is exceeded.
+  Function Rebuild(const VertexPtr& vertex,
+                   const std::unordered_map<int, int>& orders,
+                   ReorderBudget::Timer* timer,
+                   std::unordered_map<int, Function>* results) noexcept;
+
   /// Computes minimum and maximum ids for keys in computation tables.
   ///
   /// @param[in] arg_one  First argument function graph.
@@ -982,8 +1245,13 @@ class Bdd : private boost::noncopyable {
 
   std::unordered_map<int, Function> modules_;  ///< Module graphs.
   std::unordered_map<int, int> index_to_order_;  ///< Indices and orders.
+  VertexPool<Ite>::Handle pool_;  ///< The memory of the vertices.
   const TerminalPtr kOne_;  ///< Terminal True.
   int function_id_;  ///< Identification assignment for new function graphs.
+  int reorder_threshold_;  ///< The function size to trigger reordering.
+  /// The reordering time limit shared with the module conversions
+  /// or nullptr without reordering.
+  std::shared_ptr<ReorderBudget> reorder_budget_;
   std::unique_ptr<Zbdd> zbdd_;  ///< ZBDD as a result of analysis.
 };
 
@@ -0,0 +1,442 @@
+/*
+ * Copyright (C) 2018 Olzhas Rakhimov
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// Implementation of the binary report writer and reader.
+
+#include "binary_report.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+
+#include <boost/exception/errinfo_errno.hpp>
+#include <boost/exception/errinfo_file_name.hpp>
+#include <boost/exception/errinfo_file_open_mode.hpp>
+#include <boost/interprocess/exceptions.hpp>
+
+#include "error.h"
+#include "event.h"
+#include "logger.h"
+
+namespace scram {
+
+namespace {
+
+/// Sequential writer of the binary report sections.
+class Writer {
+ public:
+  /// @param[out] out  The seekable destination stream.
+  ///
+  /// @pre The stream is at its beginning.
+  explicit Writer(std::FILE* out) : out_(out) { strings_.emplace_back(); }
+
+  /// Writes raw bytes at the current position.
+  ///
+  /// @throws IOError  The write operation has failed.
+  void Write(const void* data, std::size_t size) {
+    if (size && std::fwrite(data, 1, size, out_) != size)
+      SCRAM_THROW(IOError("Failed to write the binary report."))
+          << boost::errinfo_errno(errno);
+    pos_ += size;
+  }
+
+  /// Writes a trivially copyable value or an array of values.
+  template <typename T>
+  void Write(const T* data, std::size_t count = 1) {
+    Write(static_cast<const void*>(data), sizeof(T) * count);
+  }
+
+  /// @returns The current position in the stream.
+  std::uint64_t Tell() const { return pos_; }
+
+  /// Moves to a position in the stream.
+  /// Positions past the end are filled with zeros on the next write.
+  ///
+  /// @note The 64-bit seek functions are used
+  ///       since the long offsets of std::fseek are 32-bit on LLP64 platforms.
+  void Seek(std::uint64_t pos) {
+#ifdef _WIN32
+    int ret = _fseeki64(out_, pos, SEEK_SET);
+#else
+    int ret = fseeko(out_, pos, SEEK_SET);
+#endif
+    if (ret)
+      SCRAM_THROW(IOError("Failed to seek in the binary report."))
+          << boost::errinfo_errno(errno);
+    pos_ = pos;
+  }
+
+  /// Pads the stream with zeros up to the 8-byte alignment.
+  ///
+  /// @returns The aligned position.
+  std::uint64_t Align() {
+    static const char kZeros[8] = {};
+    std::uint64_t pos = Tell();
+    if (std::uint64_t rem = pos % 8) {
+      Write(kZeros, 8 - rem);
+      pos += 8 - rem;
+    }
+    return pos;
+  }
+
+  /// @returns The index of the string in the string table.
+  std::uint32_t String(const std::string& str) {
+    if (str.empty())
+      return 0;
+    auto [it, inserted] = string_indices_.emplace(str, strings_.size());
+    if (inserted)
+      strings_.push_back(str);
+    return it->second;
+  }
+
+  /// @returns The index of the event in the event dictionary.
+  std::uint32_t Event(const mef::BasicEvent& event) {
+    auto [it, inserted] = event_indices_.emplace(&event, events_.size());
+    if (inserted)
+      events_.push_back(String(event.id()));
+    return it->second;
+  }
+
+  /// Writes the string table at the current position.
+  ///
+  /// @returns The offset of the table.
+  std::uint64_t WriteStrings() {
+    std::uint64_t offset = Align();
+    std::vector<std::uint64_t> offsets = {0};
+    for (const std::string& str : strings_)
+      offsets.push_back(offsets.back() + str.size() + 1);
+    Write(offsets.data(), offsets.size());
+    for (const std::string& str : strings_)
+      Write(str.c_str(), str.size() + 1);
+    return offset;
+  }
+
+  /// Writes the event dictionary at the current position.
+  ///
+  /// @returns The offset of the dictionary.
+  std::uint64_t WriteEvents() {
+    std::uint64_t offset = Align();
+    Write(events_.data(), events_.size());
+    return offset;
+  }
+
+  /// @returns The number of strings in the table.
+  std::uint64_t num_strings() const { return strings_.size(); }
+
+  /// @returns The number of events in the dictionary.
+  std::uint64_t num_events() const { return events_.size(); }
+
+ private:
+  std::FILE* out_;  ///< The destination stream.
+  std::uint64_t pos_ = 0;  ///< The current position in the stream.
+  std::vector<std::string> strings_;  ///< The string table.
+  std::unordered_map<std::string, std::uint32_t> string_indices_;
+  std::vector<std::uint32_t> events_;  ///< The event name string indices.
+  std::unordered_map<const mef::BasicEvent*, std::uint32_t> event_indices_;
+};
+
+/// Buffered output of an order group region.
+struct GroupBuffer {
+  binary::OrderEntry entry;  ///< The group entry with the region offsets.
+  std::uint64_t literals_cursor;  ///< The next write position for literals.
+  std::uint64_t probabilities_cursor;  ///< The next write position for p.
+  std::vector<std::uint32_t> literals;  ///< The pending literals.
+  std::vector<double> probabilities;  ///< The pending probabilities.
+};
+
+/// The number of pending literals before flushing a group buffer.
+const std::size_t kBufferSize = 1 << 14;
+
+/// Flushes the pending group data into its regions.
+void Flush(GroupBuffer* group, Writer* writer) {
+  if (!group->literals.empty()) {
+    writer->Seek(group->literals_cursor);
+    writer->Write(group->literals.data(), group->literals.size());
+    group->literals_cursor += group->literals.size() * sizeof(std::uint32_t);
+    group->literals.clear();
+  }
+  if (!group->probabilities.empty()) {
+    writer->Seek(group->probabilities_cursor);
+    writer->Write(group->probabilities.data(), group->probabilities.size());
+    group->probabilities_cursor += group->probabilities.size() * sizeof(double);
+    group->probabilities.clear();
+  }
+}
+
+/// Writes the products of a result at the current position.
+///
+/// @param[in] result  The analysis result with products.
+/// @param[in,out] writer  The report writer.
+///
+/// @returns The result entry for the results table.
+binary::ResultEntry WriteResult(const core::RiskAnalysis::Result& result,
+                                Writer* writer) {
+  binary::ResultEntry entry{};
+  if (const mef::Gate* const* gate = std::get_if<const mef::Gate*>(
+          &result.id.target)) {
+    entry.name = writer->String((*gate)->id());
+  } else {
+    const auto& sequence = std::get<1>(result.id.target);
+    entry.name = writer->String(sequence.second.name());
+    entry.initiating_event = writer->String(sequence.first.name());
+  }
+  if (result.id.context) {
+    entry.alignment = writer->String(result.id.context->alignment.name());
+    entry.phase = writer->String(result.id.context->phase.name());
+  }
+  entry.probability = result.probability_analysis
+                          ? result.probability_analysis->p_total()
+                          : std::numeric_limits<double>::quiet_NaN();
+  bool with_probabilities = result.probability_analysis != nullptr;
+
+  const core::ProductContainer& products =
+      result.fault_tree_analysis->products();
+  entry.num_products = products.size();
+  // The Unity product is counted with the first order in the distribution.
+  bool unity = !products.empty() && products.begin()->empty();
+  std::vector<GroupBuffer> groups;
+  if (unity) {
+    groups.push_back({{0, 1}});
+  } else {
+    for (int i = 0; i < products.Distribution().size(); ++i) {
+      if (int count = products.Distribution()[i])
+        groups.push_back({{static_cast<std::uint64_t>(i + 1),
+                           static_cast<std::uint64_t>(count)}});
+    }
+  }
+  entry.num_orders = groups.size();
+  entry.orders_offset = writer->Align();
+
+  // The regions are laid out in advance
+  // to stream the products in a single pass.
+  std::uint64_t pos =
+      entry.orders_offset + groups.size() * sizeof(binary::OrderEntry);
+  for (GroupBuffer& group : groups) {
+    std::uint64_t num_literals = group.entry.order * group.entry.num_products;
+    group.entry.literals_offset = pos;
+    pos += num_literals * sizeof(std::uint32_t);
+    pos += (8 - pos % 8) % 8;
+    if (with_probabilities) {
+      group.entry.probabilities_offset = pos;
+      pos += group.entry.num_products * sizeof(double);
+    }
+    group.literals_cursor = group.entry.literals_offset;
+    group.probabilities_cursor = group.entry.probabilities_offset;
+    writer->Write(&group.entry);
+  }
+  std::uint64_t end = pos;
+
+  std::vector<int> index_of_order(unity ? 1 : products.Distribution().size() +
+                                                  1);
+  for (int i = 0; i < groups.size(); ++i)
+    index_of_order[groups[i].entry.order] = i;
+
+  std::vector<std::uint32_t> codes;
+  for (const core::Product& product : products) {
+    GroupBuffer& group = groups[index_of_order[product.size()]];
+    codes.clear();
+    for (const core::Literal& literal : product)
+      codes.push_back(writer->Event(literal.event) << 1 | literal.complement);
+    std::sort(codes.begin(), codes.end());
+    group.literals.insert(group.literals.end(), codes.begin(), codes.end());
+    if (with_probabilities)
+      group.probabilities.push_back(product.p());
+    if (group.literals.size() >= kBufferSize ||
+        group.probabilities.size() >= kBufferSize) {
+      Flush(&group, writer);
+    }
+  }
+  for (GroupBuffer& group : groups)
+    Flush(&group, writer);
+  writer->Seek(end);
+  return entry;
+}
+
+}  // namespace
+
+void BinaryReporter::Report(const core::RiskAnalysis& risk_an,
+                            std::FILE* out) {
+  TIMER(DEBUG1, "Reporting binary products");
+  Writer writer(out);
+  binary::Header header{};
+  std::memcpy(header.magic, binary::kMagic, sizeof(header.magic));
+  header.version = binary::kVersion;
+  header.byte_order = binary::kByteOrder;
+  writer.Write(&header);  // The placeholder till the end.
+
+  std::vector<const core::RiskAnalysis::Result*> results;
+  for (const core::RiskAnalysis::Result& result : risk_an.results()) {
+    if (result.fault_tree_analysis)
+      results.push_back(&result);
+  }
+  header.num_results = results.size();
+  header.results_offset = writer.Align();
+  std::vector<binary::ResultEntry> entries(results.size());
+  writer.Write(entries.data(), entries.size());  // The placeholder.
+  for (int i = 0; i < results.size(); ++i)
+    entries[i] = WriteResult(*results[i], &writer);
+
+  header.num_strings = writer.num_strings();
+  header.strings_offset = writer.WriteStrings();
+  header.num_events = writer.num_events();
+  header.events_offset = writer.WriteEvents();
+
+  writer.Seek(0);
+  writer.Write(&header);
+  writer.Seek(header.results_offset);
+  writer.Write(entries.data(), entries.size());
+  if (std::fflush(out))
+    SCRAM_THROW(IOError("Failed to write the binary report."))
+        << boost::errinfo_errno(errno);
+}
+
+void BinaryReporter::Report(const core::RiskAnalysis& risk_an,
+                            const std::string& file) {
+  std::unique_ptr<std::FILE, decltype(&std::fclose)> fp(
+      std::fopen(file.c_str(), "wb"), &std::fclose);
+  try {
+    if (!fp) {
+      SCRAM_THROW(IOError("Cannot open the output file for binary report."))
+          << boost::errinfo_errno(errno) << boost::errinfo_file_open_mode("wb");
+    }
+    Report(risk_an, fp.get());
+  } catch (IOError& err) {
+    err << boost::errinfo_file_name(file);
+    throw;
+  }
+}
+
+void BinaryReport::Group::product(std::size_t index,
+                                  std::vector<Literal>* literals) const {
+  const std::uint32_t* codes =
+      reinterpret_cast<const std::uint32_t*>(data_ + entry_.literals_offset) +
+      index * entry_.order;
+  literals->clear();
+  for (int i = 0; i < entry_.order; ++i) {
+    if ((codes[i] >> 1) >= num_events_)
+      SCRAM_THROW(IOError("The binary report event index is out of range."));
+    literals->push_back({static_cast<bool>(codes[i] & 1),
+                         static_cast<int>(codes[i] >> 1)});
+  }
+}
+
+BinaryReport::Group BinaryReport::Result::group(int index) const {
+  return Group(reinterpret_cast<const binary::OrderEntry*>(
+                   report_.data() + entry_.orders_offset)[index],
+               report_.data(), report_.header().num_events);
+}
+
+BinaryReport::BinaryReport(const std::string& file) {
+  try {
+    file_ = boost::interprocess::file_mapping(file.c_str(),
+                                              boost::interprocess::read_only);
+    region_ = boost::interprocess::mapped_region(
+        file_, boost::interprocess::read_only);
+  } catch (const boost::interprocess::interprocess_exception& err) {
+    SCRAM_THROW(IOError(err.what())) << boost::errinfo_file_name(file);
+  }
+  try {
+    Validate();
+  } catch (IOError& err) {
+    err << boost::errinfo_file_name(file);
+    throw;
+  }
+}
+
+std::string_view BinaryReport::string(std::uint32_t index) const {
+  const auto* offsets = reinterpret_cast<const std::uint64_t*>(
+      data() + header().strings_offset);
+  const char* chars =
+      reinterpret_cast<const char*>(offsets + header().num_strings + 1);
+  return std::string_view(chars + offsets[index],
+                          offsets[index + 1] - offsets[index] - 1);
+}
+
+void BinaryReport::Validate() const {
+  std::uint64_t size = region_.get_size();
+  // Checks that the section of the given size is within the file.
+  auto check = [size](std::uint64_t offset, std::uint64_t count,
+                      std::uint64_t width) {
+    if (offset % 8 || offset > size || (size - offset) / width < count)
+      SCRAM_THROW(IOError("The binary report section is out of bounds."));
+  };
+  if (size < sizeof(binary::Header) ||
+      std::memcmp(header().magic, binary::kMagic, sizeof(binary::kMagic))) {
+    SCRAM_THROW(IOError("The file is not a SCRAM binary report."));
+  }
+  if (header().version != binary::kVersion)
+    SCRAM_THROW(IOError("Unsupported binary report version."));
+  if (header().byte_order != binary::kByteOrder)
+    SCRAM_THROW(IOError("The binary report byte order does not match."));
+
+  check(header().strings_offset, header().num_strings + 1,
+        sizeof(std::uint64_t));
+  const auto* offsets = reinterpret_cast<const std::uint64_t*>(
+      data() + header().strings_offset);
+  std::uint64_t chars_offset =
+      header().strings_offset + (header().num_strings + 1) * sizeof(*offsets);
+  if (!header().num_strings || offsets[0] != 0 ||
+      offsets[header().num_strings] > size - chars_offset) {
+    SCRAM_THROW(IOError("The binary report string table is invalid."));
+  }
+  for (std::uint64_t i = 0; i < header().num_strings; ++i) {
+    if (offsets[i + 1] <= offsets[i] ||
+        data()[chars_offset + offsets[i + 1] - 1] != '\0') {
+      SCRAM_THROW(IOError("The binary report string table is invalid."));
+    }
+  }
+  auto check_string = [this](std::uint32_t index) {
+    if (index >= header().num_strings)
+      SCRAM_THROW(IOError("The binary report string index is out of range."));
+  };
+
+  check(header().events_offset, header().num_events, sizeof(std::uint32_t));
+  for (int i = 0; i < num_events(); ++i)
+    check_string(reinterpret_cast<const std::uint32_t*>(
+        data() + header().events_offset)[i]);
+
+  check(header().results_offset, header().num_results,
+        sizeof(binary::ResultEntry));
+  for (int i = 0; i < num_results(); ++i) {
+    const binary::ResultEntry& entry = reinterpret_cast<
+        const binary::ResultEntry*>(data() + header().results_offset)[i];
+    check_string(entry.name);
+    check_string(entry.initiating_event);
+    check_string(entry.alignment);
+    check_string(entry.phase);
+    check(entry.orders_offset, entry.num_orders, sizeof(binary::OrderEntry));
+    for (std::uint64_t j = 0; j < entry.num_orders; ++j) {
+      const binary::OrderEntry& group = reinterpret_cast<
+          const binary::OrderEntry*>(data() + entry.orders_offset)[j];
+      if (group.order && group.num_products > size / group.order)
+        SCRAM_THROW(IOError("The binary report section is out of bounds."));
+      check(group.literals_offset, group.order * group.num_products,
+            sizeof(std::uint32_t));
+      if (group.probabilities_offset)
+        check(group.probabilities_offset, group.num_products, sizeof(double));
+    }
+  }
+}
+
+}  // namespace scram
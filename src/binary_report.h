@@ -0,0 +1,282 @@
+/*
+ * Copyright (C) 2018 Olzhas Rakhimov
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// Binary, memory-mappable report of analysis products.
+///
+/// The file layout (all numbers in the byte order of the writer,
+/// all sections aligned at 8 bytes):
+///
+///   - binary::Header
+///   - binary::ResultEntry[num_results]
+///   - For each result:
+///       binary::OrderEntry[num_orders],
+///       then for each order group
+///       the literals (uint32[num_products * order]) padded to 8 bytes
+///       and the optional probabilities (double[num_products]).
+///   - The string table:
+///       uint64 offsets[num_strings + 1] into the following characters;
+///       every string is NUL-terminated.
+///   - The event dictionary: uint32 string indices[num_events].
+///
+/// A literal is encoded as (event_index << 1 | complement).
+/// The literals of a product are stored as sorted plain codes,
+/// so that every product of a group has the same fixed width
+/// and every literal is accessible in place.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "risk_analysis.h"
+
+namespace scram {
+
+namespace binary {
+
+/// The file signature.
+inline constexpr char kMagic[8] = {'S', 'C', 'R', 'A', 'M', 'P', 'R', 'D'};
+/// The version of the layout.
+inline constexpr std::uint32_t kVersion = 2;
+/// The marker to detect the byte order of the writer.
+inline constexpr std::uint32_t kByteOrder = 0x01020304;
+
+/// The file header.
+struct Header {
+  char magic[8];  ///< kMagic.
+  std::uint32_t version;  ///< kVersion.
+  std::uint32_t byte_order;  ///< kByteOrder in the native byte order.
+  std::uint64_t num_results;  ///< The number of result entries.
+  std::uint64_t results_offset;  ///< The ResultEntry table.
+  std::uint64_t num_events;  ///< The number of dictionary events.
+  std::uint64_t events_offset;  ///< The event dictionary.
+  std::uint64_t num_strings;  ///< The number of strings in the table.
+  std::uint64_t strings_offset;  ///< The string table.
+};
+
+/// The products of an analysis target.
+struct ResultEntry {
+  std::uint32_t name;  ///< The string index of the gate or sequence name.
+  std::uint32_t initiating_event;  ///< The string index or 0 (empty).
+  std::uint32_t alignment;  ///< The string index or 0 (empty).
+  std::uint32_t phase;  ///< The string index or 0 (empty).
+  double probability;  ///< The total probability or NaN.
+  std::uint64_t num_products;  ///< The total number of products.
+  std::uint64_t num_orders;  ///< The number of order groups.
+  std::uint64_t orders_offset;  ///< The OrderEntry table.
+};
+
+/// The products of the same order in a result.
+struct OrderEntry {
+  std::uint64_t order;  ///< The number of literals per product.
+  std::uint64_t num_products;  ///< The number of products in the group.
+  std::uint64_t literals_offset;  ///< The sorted literal codes.
+  std::uint64_t probabilities_offset;  ///< The probabilities or 0 if none.
+};
+
+static_assert(sizeof(Header) == 64);
+static_assert(sizeof(ResultEntry) == 48);
+static_assert(sizeof(OrderEntry) == 32);
+
+}  // namespace binary
+
+/// Writer of the products of risk analysis into the binary format.
+/// The products are streamed from the analysis results
+/// without materializing them in memory.
+class BinaryReporter {
+ public:
+  /// Reports the products of all the analysis targets.
+  ///
+  /// @param[in] risk_an  Risk analysis with results.
+  /// @param[out] out  The seekable binary destination stream.
+  ///
+  /// @throws IOError  The write operation has failed.
+  void Report(const core::RiskAnalysis& risk_an, std::FILE* out);
+
+  /// A convenience function to generate the report into a file.
+  /// This function overwrites the file.
+  ///
+  /// @param[in] risk_an  Risk analysis with results.
+  /// @param[out] file  The output destination.
+  ///
+  /// @throws IOError  The output file is not accessible,
+  ///                  or the write operation has failed.
+  void Report(const core::RiskAnalysis& risk_an, const std::string& file);
+};
+
+/// Read-only, memory-mapped view of the binary report.
+/// The data is accessed in place without parsing or copying.
+///
+/// @note All the views into the report are valid
+///       only while the report object is alive.
+class BinaryReport {
+ public:
+  /// Decoded literal of a product.
+  struct Literal {
+    bool complement;  ///< Indication of a complement event.
+    int event;  ///< The index of the event in the dictionary.
+  };
+
+  /// Products of the same order.
+  class Group {
+   public:
+    /// @param[in] entry  The group entry in the report.
+    /// @param[in] data  The start of the mapped report.
+    /// @param[in] num_events  The number of events in the dictionary.
+    Group(const binary::OrderEntry& entry, const char* data,
+          std::uint64_t num_events)
+        : entry_(entry), data_(data), num_events_(num_events) {}
+
+    /// @returns The number of literals in each product of the group.
+    int order() const { return entry_.order; }
+
+    /// @returns The number of products in the group.
+    std::size_t size() const { return entry_.num_products; }
+
+    /// Decodes a product of the group.
+    ///
+    /// @param[in] index  The index of the product in the group.
+    /// @param[out] literals  The sorted literals of the product.
+    ///
+    /// @throws IOError  A literal refers to an event outside the dictionary.
+    void product(std::size_t index, std::vector<Literal>* literals) const;
+
+    /// @returns true if the group stores product probabilities.
+    bool has_probabilities() const { return entry_.probabilities_offset; }
+
+    /// @param[in] index  The index of the product in the group.
+    ///
+    /// @returns The probability of the product.
+    ///
+    /// @pre The group has probabilities.
+    double probability(std::size_t index) const {
+      return reinterpret_cast<const double*>(
+          data_ + entry_.probabilities_offset)[index];
+    }
+
+   private:
+    const binary::OrderEntry& entry_;  ///< The group entry.
+    const char* data_;  ///< The mapped report.
+    std::uint64_t num_events_;  ///< The size of the event dictionary.
+  };
+
+  /// Products of an analysis target.
+  class Result {
+   public:
+    /// @param[in] entry  The result entry in the report.
+    /// @param[in] report  The host report.
+    Result(const binary::ResultEntry& entry, const BinaryReport& report)
+        : entry_(entry), report_(report) {}
+
+    /// Identifiers of the analysis target.
+    /// The optional identifiers are empty if not applicable.
+    /// @{
+    std::string_view name() const { return report_.string(entry_.name); }
+    std::string_view initiating_event() const {
+      return report_.string(entry_.initiating_event);
+    }
+    std::string_view alignment() const {
+      return report_.string(entry_.alignment);
+    }
+    std::string_view phase() const { return report_.string(entry_.phase); }
+    /// @}
+
+    /// @returns The total probability or NaN without probability analysis.
+    double probability() const { return entry_.probability; }
+
+    /// @returns The total number of products.
+    std::size_t num_products() const { return entry_.num_products; }
+
+    /// @returns The number of order groups in increasing order.
+    int num_groups() const { return entry_.num_orders; }
+
+    /// @param[in] index  The index of the group.
+    ///
+    /// @returns The products of the group.
+    Group group(int index) const;
+
+   private:
+    const binary::ResultEntry& entry_;  ///< The result entry.
+    const BinaryReport& report_;  ///< The host report.
+  };
+
+  /// Maps the report file into memory and validates its layout.
+  ///
+  /// @param[in] file  The binary report file.
+  ///
+  /// @throws IOError  The file is not accessible or not a valid report.
+  explicit BinaryReport(const std::string& file);
+
+  /// @returns The number of events in the dictionary.
+  int num_events() const { return header().num_events; }
+
+  /// @param[in] index  The index of the event in the dictionary.
+  ///
+  /// @returns The identifier of the event.
+  std::string_view event(int index) const {
+    return string(reinterpret_cast<const std::uint32_t*>(
+        data() + header().events_offset)[index]);
+  }
+
+  /// @returns The number of analysis results.
+  int num_results() const { return header().num_results; }
+
+  /// @param[in] index  The index of the result.
+  ///
+  /// @returns The view of the result.
+  Result result(int index) const {
+    return Result(reinterpret_cast<const binary::ResultEntry*>(
+                      data() + header().results_offset)[index],
+                  *this);
+  }
+
+ private:
+  /// @returns The start of the mapped data.
+  const char* data() const {
+    return static_cast<const char*>(region_.get_address());
+  }
+
+  /// @returns The file header.
+  const binary::Header& header() const {
+    return *reinterpret_cast<const binary::Header*>(data());
+  }
+
+  /// @param[in] index  The index of the string in the table.
+  ///
+  /// @returns The string from the table.
+  std::string_view string(std::uint32_t index) const;
+
+  /// Checks the section offsets and sizes against the file size
+  /// and the string indices against the string table.
+  /// The event indices of literals are checked upon decoding.
+  ///
+  /// @throws IOError  The layout is invalid.
+  void Validate() const;
+
+  boost::interprocess::file_mapping file_;  ///< The mapped file.
+  boost::interprocess::mapped_region region_;  ///< The mapped contents.
+};
+
+}  // namespace scram
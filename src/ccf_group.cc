@@ -160,8 +160,9 @@ void CcfGroup::ApplyModel() {
              level, proxy_gates.begin(), proxy_gates.end())) {
       auto ccf_event = std::make_unique<CcfEvent>(JoinNames(combination), this);
       ccf_event->expression(prob);
+      // The combinations are unique by construction.
       for (Gate* gate : combination)
-        gate->formula().AddArgument(ccf_event.get());
+        gate->formula().AddUniqueArgument(ccf_event.get());
       ccf_event->members(std::move(combination));  // Move, at last.
       ccf_events_.emplace_back(std::move(ccf_event));
     }
@@ -111,6 +111,9 @@ void Config::GatherOptions(const xml::Element& root) {
       } else if (name == "approximation") {
         settings_.approximation(option_group.attribute("name"));
 
+      } else if (name == "variable-order") {
+        settings_.variable_order(option_group.attribute("name"));
+
       } else if (name == "limits") {
         SetLimits(option_group);
       }
@@ -155,6 +158,9 @@ void Config::SetLimits(const xml::Element& limits) {
     } else if (name == "cut-off") {
       settings_.cut_off(limit.text<double>());
 
+    } else if (name == "top-products") {
+      settings_.top_products(limit.text<int>());
+
     } else if (name == "mission-time") {
       settings_.mission_time(limit.text<double>());
 
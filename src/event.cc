@@ -97,6 +97,11 @@ void Formula::AddArgument(EventArg event_arg) {
       })) {
     SCRAM_THROW(DuplicateArgumentError("Duplicate argument " + event->name()));
   }
+  AddUniqueArgument(event_arg);
+}
+
+void Formula::AddUniqueArgument(EventArg event_arg) {
+  Event* event = ext::as<Event*>(event_arg);
   event_args_.push_back(event_arg);
   if (!event->usage())
     event->usage(true);
@@ -290,6 +290,16 @@ class Formula : private boost::noncopyable {
   void Validate() const;
 
  private:
+  friend class CcfGroup;  // Expands CCF events into member formulas.
+
+  /// Adds an event into the arguments list
+  /// without the linear search for duplicates.
+  ///
+  /// @param[in] event_arg  An argument event.
+  ///
+  /// @pre The argument event is distinct from the other arguments.
+  void AddUniqueArgument(EventArg event_arg);
+
   Operator type_;  ///< Logical operator.
   int vote_number_;  ///< Vote number for "atleast" operator.
   std::vector<EventArg> event_args_;  ///< All event arguments.
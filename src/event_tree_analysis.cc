@@ -19,6 +19,7 @@
 
 #include "event_tree_analysis.h"
 
+#include "expression/constant.h"
 #include "expression/numerical.h"
 #include "ext/find_iterator.h"
 #include "instruction.h"
@@ -158,6 +159,32 @@ void EventTreeAnalysis::Analyze() noexcept {
   }
 }
 
+std::pair<std::unique_ptr<mef::Gate>, std::vector<const mef::BasicEvent*>>
+EventTreeAnalysis::JoinSequences(
+    const std::vector<const Result*>& sequences) noexcept {
+  auto gate = std::make_unique<mef::Gate>("__" + initiating_event_.name());
+  auto sequence_formula = std::make_unique<mef::Formula>(mef::kOr);
+  auto selector_formula = std::make_unique<mef::Formula>(mef::kOr);
+  std::vector<const mef::BasicEvent*> selectors;
+  for (const Result* sequence : sequences) {
+    assert(!sequence->is_expression_only && "Nothing to share.");
+    auto selector = std::make_unique<mef::BasicEvent>(
+        "__selector__" + sequence->sequence.name());
+    selector->expression(&mef::ConstantExpression::kOne);
+    auto and_formula = std::make_unique<mef::Formula>(mef::kAnd);
+    and_formula->AddArgument(selector.get());
+    and_formula->AddArgument(sequence->gate.get());
+    sequence_formula->AddArgument(std::move(and_formula));
+    selector_formula->AddArgument(selector.get());
+    selectors.push_back(selector.get());
+    events_.push_back(std::move(selector));
+  }
+  gate->formula(std::make_unique<mef::Formula>(mef::kAnd));
+  gate->formula().AddArgument(std::move(sequence_formula));
+  gate->formula().AddArgument(std::move(selector_formula));
+  return {std::move(gate), std::move(selectors)};
+}
+
 void EventTreeAnalysis::CollectSequences(const mef::Branch& initial_state,
                                          SequenceCollector* result) noexcept {
   struct Collector {
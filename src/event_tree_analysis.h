@@ -22,6 +22,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "analysis.h"
@@ -29,6 +30,7 @@
 #include "event_tree.h"
 #include "expression.h"
 #include "expression/test_event.h"
+#include "ext/linear_map.h"
 #include "settings.h"
 
 namespace scram::core {
@@ -66,6 +68,24 @@ class EventTreeAnalysis : public Analysis {
   std::vector<Result>& sequences() { return sequences_; }
   /// @}
 
+  /// Joins the sequence formulas into a single gate
+  /// for the analysis of the sequences with one shared PDAG:
+  /// (s_1 & S_1 | ... | s_n & S_n) & (s_1 | ... | s_n),
+  /// where s_i is a new unique selector event of the sequence S_i.
+  /// The formula of S_i is the restriction of the joint gate
+  /// with s_i set to true and the rest of the selectors set to false.
+  ///
+  /// @param[in] sequences  The sequences with formulas to join.
+  ///
+  /// @returns The joint gate
+  ///          and the selector events in the order of the sequences.
+  ///
+  /// @pre The analysis is done.
+  ///
+  /// @post The selector events live as long as this analysis.
+  std::pair<std::unique_ptr<mef::Gate>, std::vector<const mef::BasicEvent*>>
+  JoinSequences(const std::vector<const Result*>& sequences) noexcept;
+
  private:
   /// Expressions and formulas collected in an event tree path.
   struct PathCollector {
@@ -80,8 +100,9 @@ class EventTreeAnalysis : public Analysis {
   struct SequenceCollector {
     const mef::InitiatingEvent& initiating_event;  ///< The analysis initiator.
     mef::Context& context;  ///< The collection context.
-    /// Sequences with collected paths.
-    std::unordered_map<const mef::Sequence*, std::vector<PathCollector>>
+    /// Sequences with collected paths
+    /// in the deterministic order of the first reach in the traversal.
+    ext::linear_map<const mef::Sequence*, std::vector<PathCollector>>
         sequences;
   };
 
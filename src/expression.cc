@@ -22,6 +22,8 @@
 
 #include <sstream>
 
+#include <boost/range/algorithm/find.hpp>
+
 #include "error.h"
 #include "ext/algorithm.h"
 
@@ -46,6 +48,13 @@ void Expression::Reset() noexcept {
     arg->Reset();
 }
 
+void Expression::ReplaceArg(Expression* arg,
+                            Expression* replacement) noexcept {
+  auto it = boost::find(args_, arg);
+  assert(it != args_.end() && "The argument is not registered.");
+  *it = replacement;
+}
+
 bool Expression::IsDeviate() noexcept {
   return ext::any_of(args_, [](Expression* arg) { return arg->IsDeviate(); });
 }
@@ -121,6 +121,12 @@ class Expression : private boost::noncopyable {
   /// @param[in] arg  An argument expression used by this expression.
   void AddArg(Expression* arg) { args_.push_back(arg); }
 
+  /// Replaces a registered argument expression.
+  ///
+  /// @param[in] arg  The registered argument of this expression.
+  /// @param[in] replacement  The new argument expression.
+  void ReplaceArg(Expression* arg, Expression* replacement) noexcept;
+
  private:
   /// Runs sampling of the expression.
   /// Derived concrete classes must provide the calculation.
@@ -52,6 +52,15 @@ class RandomDeviate : public Expression {
   /// @note This is static! Used by all the deriving deviates.
   static void seed(unsigned seed) noexcept { rng_.seed(seed); }
 
+  /// Seeds the whole state of the underlying random number generator.
+  ///
+  /// @param[in] seed_sequence  The seed sequence for independent streams.
+  ///
+  /// @note This is static! Used by all the deriving deviates.
+  static void seed(std::seed_seq& seed_sequence) noexcept {
+    rng_.seed(seed_sequence);
+  }
+
  protected:
   /// @returns RNG to be used by derived classes.
   std::mt19937& rng() { return rng_; }
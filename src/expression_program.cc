@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2018 Olzhas Rakhimov
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// Implementation of the expression compilation and batched evaluation.
+
+#include "expression_program.h"
+
+#include <algorithm>
+
+#include <boost/algorithm/cxx11/any_of.hpp>
+
+#include "expression/boolean.h"
+#include "expression/exponential.h"
+#include "expression/numerical.h"
+
+namespace scram::mef {
+
+namespace {
+
+/// Batch kernels for compiled expression types.
+///
+/// @tparam E  The expression type.
+template <class E>
+struct BatchKernel;
+
+/// Unary operations.
+template <typename T>
+struct BatchKernel<NaryExpression<T, 1>> {
+  /// @copydoc ExpressionProgram::Kernel
+  static void Run(Expression* /*expression*/, const double* const* args,
+                  int /*num_args*/, int num_lanes, double* result) {
+    const double* arg = args[0];
+    for (int j = 0; j < num_lanes; ++j)
+      result[j] = T()(arg[j]);
+  }
+};
+
+/// Binary operations.
+template <typename T>
+struct BatchKernel<NaryExpression<T, 2>> {
+  /// @copydoc ExpressionProgram::Kernel
+  static void Run(Expression* /*expression*/, const double* const* args,
+                  int /*num_args*/, int num_lanes, double* result) {
+    const double* arg_one = args[0];
+    const double* arg_two = args[1];
+    for (int j = 0; j < num_lanes; ++j)
+      result[j] = T()(arg_one[j], arg_two[j]);
+  }
+};
+
+/// Left folds of multivariate operations.
+template <typename T>
+struct BatchKernel<NaryExpression<T, -1>> {
+  /// @copydoc ExpressionProgram::Kernel
+  static void Run(Expression* /*expression*/, const double* const* args,
+                  int num_args, int num_lanes, double* result) {
+    std::copy_n(args[0], num_lanes, result);
+    for (int i = 1; i < num_args; ++i) {
+      const double* arg = args[i];
+      for (int j = 0; j < num_lanes; ++j)
+        result[j] = T()(result[j], arg[j]);
+    }
+  }
+};
+
+/// The average of arguments.
+template <>
+struct BatchKernel<Mean> {
+  /// @copydoc ExpressionProgram::Kernel
+  static void Run(Expression* /*expression*/, const double* const* args,
+                  int num_args, int num_lanes, double* result) {
+    BatchKernel<Add>::Run(nullptr, args, num_args, num_lanes, result);
+    for (int j = 0; j < num_lanes; ++j)
+      result[j] /= num_args;
+  }
+};
+
+/// The exponential failure probability.
+template <>
+struct BatchKernel<Exponential> {
+  /// @copydoc ExpressionProgram::Kernel
+  static void Run(Expression* expression, const double* const* args,
+                  int /*num_args*/, int num_lanes, double* result) {
+    auto* formula = static_cast<Exponential*>(expression);
+    for (int j = 0; j < num_lanes; ++j)
+      result[j] = formula->Compute(args[0][j], args[1][j]);
+  }
+};
+
+/// Failure probability formulas with four arguments in the formula order.
+template <class E>
+struct FormulaKernel {
+  /// @copydoc ExpressionProgram::Kernel
+  static void Run(Expression* expression, const double* const* args,
+                  int /*num_args*/, int num_lanes, double* result) {
+    auto* formula = static_cast<E*>(expression);
+    for (int j = 0; j < num_lanes; ++j) {
+      result[j] =
+          formula->Compute(args[0][j], args[1][j], args[2][j], args[3][j]);
+    }
+  }
+};
+
+template <>
+struct BatchKernel<Glm> : public FormulaKernel<Glm> {};
+template <>
+struct BatchKernel<Weibull> : public FormulaKernel<Weibull> {};
+
+/// Finds the kernel for the expression among the given types.
+///
+/// @tparam Ts  The compiled expression types.
+///
+/// @param[in] expression  The expression to compile.
+///
+/// @returns The kernel of the expression type.
+/// @returns nullptr if the expression type is not among the types.
+template <class... Ts>
+ExpressionProgram::Kernel FindKernel(Expression* expression) {
+  ExpressionProgram::Kernel kernel = nullptr;
+  (void)((dynamic_cast<Ts*>(expression) && (kernel = &BatchKernel<Ts>::Run)) ||
+         ...);
+  return kernel;
+}
+
+}  // namespace
+
+bool ExpressionProgram::IsDynamic(Expression* expression) {
+  if (expression == mission_time_)
+    return true;
+  if (auto it = dynamic_.find(expression); it != dynamic_.end())
+    return it->second;
+  bool dynamic =
+      boost::algorithm::any_of(expression->args(), [this](Expression* arg) {
+        return IsDynamic(arg);
+      });
+  dynamic_.emplace(expression, dynamic);
+  return dynamic;
+}
+
+int ExpressionProgram::Compile(Expression* expression) {
+  if (auto it = registers_.find(expression); it != registers_.end())
+    return it->second;
+  int result = 0;
+  if (!IsDynamic(expression)) {
+    result = num_registers_++;
+    values_.emplace_back(result, expression);
+  } else if (dynamic_cast<Parameter*>(expression)) {
+    result = Compile(expression->args().front());
+  } else if (Kernel kernel =
+                 FindKernel<Neg, Add, Sub, Mul, Div, Abs, Acos, Asin, Atan,
+                            Cos, Sin, Tan, Cosh, Sinh, Tanh, Exp, Log, Log10,
+                            Mod, Pow, Sqrt, Ceil, Floor, Min, Max, Mean, Not,
+                            And, Or, Eq, Df, Lt, Gt, Leq, Geq, Exponential,
+                            Glm, Weibull>(expression)) {
+    std::vector<int> args;
+    for (Expression* arg : expression->args())
+      args.push_back(Compile(arg));
+    result = num_registers_++;
+    instructions_.push_back({kernel, expression, result, std::move(args)});
+  } else {
+    result = num_registers_++;
+    fallbacks_.emplace_back(result, expression);
+  }
+  registers_.emplace(expression, result);
+  return result;
+}
+
+void ExpressionProgram::Evaluate(const double* times, int num_lanes,
+                                 double* results) noexcept {
+  data_.resize(num_registers_ * num_lanes);
+  double* data = data_.data();
+  std::copy_n(times, num_lanes, data);
+  for (const auto& [result, expression] : values_)
+    std::fill_n(data + result * num_lanes, num_lanes, expression->value());
+
+  if (!fallbacks_.empty()) {
+    double mission_time = mission_time_->value();
+    for (int j = 0; j < num_lanes; ++j) {
+      mission_time_->value(times[j]);
+      for (const auto& [result, expression] : fallbacks_)
+        data[result * num_lanes + j] = expression->value();
+    }
+    mission_time_->value(mission_time);
+  }
+
+  for (const Instruction& instruction : instructions_) {
+    args_.clear();
+    for (int arg : instruction.args)
+      args_.push_back(data + arg * num_lanes);
+    instruction.kernel(instruction.expression, args_.data(),
+                       instruction.args.size(), num_lanes,
+                       data + instruction.result * num_lanes);
+  }
+
+  for (int i = 0; i < outputs_.size(); ++i)
+    std::copy_n(data + outputs_[i] * num_lanes, num_lanes,
+                results + i * num_lanes);
+}
+
+}  // namespace scram::mef
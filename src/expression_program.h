@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2018 Olzhas Rakhimov
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// Compilation of expressions into flat programs
+/// for batched evaluation over mission time values.
+
+#pragma once
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "expression.h"
+#include "parameter.h"
+
+namespace scram::mef {
+
+/// Register-based program compiled from expressions
+/// to evaluate them for a batch of mission time values (lanes) at once.
+///
+/// Only the parts of the expressions that depend on the mission time
+/// are compiled into instructions.
+/// Every instruction is executed once per batch with a loop over the lanes
+/// instead of the recursive virtual calls per value.
+/// The sub-expressions independent of the mission time
+/// are evaluated only once per batch.
+/// The time-dependent expressions without a compiled counterpart
+/// (conditionals, periodic tests, extern functions, etc.)
+/// fall back to the evaluation of the expression tree per lane.
+///
+/// @note The program is only valid
+///       as long as the expressions are alive and unchanged.
+class ExpressionProgram {
+ public:
+  /// @param[in] mission_time  The mission time input of the expressions.
+  explicit ExpressionProgram(MissionTime* mission_time)
+      : mission_time_(mission_time) {
+    registers_.emplace(mission_time, 0);
+  }
+
+  /// @param[in] expression  An expression.
+  ///
+  /// @returns true if the expression value depends on the mission time.
+  bool IsDynamic(Expression* expression);
+
+  /// Compiles an expression as the next output of the program.
+  ///
+  /// @param[in] expression  The expression to evaluate.
+  void AddOutput(Expression* expression) {
+    outputs_.push_back(Compile(expression));
+  }
+
+  /// @returns The number of compiled outputs.
+  int num_outputs() const { return outputs_.size(); }
+
+  /// Evaluates the outputs for a batch of mission time values.
+  ///
+  /// @param[in] times  The non-negative mission time values for each lane.
+  /// @param[in] num_lanes  The number of lanes in the batch.
+  /// @param[out] results  The values of the outputs in the output-major order,
+  ///                      i.e., output * num_lanes + lane.
+  ///
+  /// @post The mission time value is not changed.
+  void Evaluate(const double* times, int num_lanes, double* results) noexcept;
+
+  /// The batch operation over argument registers.
+  ///
+  /// @param[in] expression  The source expression of the instruction.
+  /// @param[in] args  The argument registers with values for each lane.
+  /// @param[in] num_args  The number of arguments.
+  /// @param[in] num_lanes  The number of lanes.
+  /// @param[out] result  The result register.
+  using Kernel = void (*)(Expression* expression, const double* const* args,
+                          int num_args, int num_lanes, double* result);
+
+ private:
+  /// Compiled operation on registers.
+  struct Instruction {
+    Kernel kernel;  ///< The operation.
+    Expression* expression;  ///< The source expression.
+    int result;  ///< The result register.
+    std::vector<int> args;  ///< The argument registers.
+  };
+
+  /// Compiles the expression and its arguments.
+  ///
+  /// @param[in] expression  The expression to compile.
+  ///
+  /// @returns The register with the expression value.
+  int Compile(Expression* expression);
+
+  MissionTime* mission_time_;  ///< The input of the program in register 0.
+  int num_registers_ = 1;  ///< The total number of registers.
+  std::vector<Instruction> instructions_;  ///< Arguments before parents.
+  /// The registers of time-independent expressions.
+  std::vector<std::pair<int, Expression*>> values_;
+  /// The registers of time-dependent expressions evaluated as trees.
+  std::vector<std::pair<int, Expression*>> fallbacks_;
+  std::vector<int> outputs_;  ///< The output registers.
+  /// The registers of compiled expressions.
+  std::unordered_map<const Expression*, int> registers_;
+  /// The memo of the mission time dependence of expressions.
+  std::unordered_map<const Expression*, bool> dynamic_;
+  std::vector<double> data_;  ///< The register values for all lanes.
+  std::vector<const double*> args_;  ///< The instruction argument registers.
+};
+
+}  // namespace scram::mef
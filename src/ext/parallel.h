@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2018 Olzhas Rakhimov
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// Minimal facilities to run independent tasks on a pool of threads.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace ext {
+
+/// Calls the function for every index in [0, count)
+/// on up to the given number of threads.
+/// The indices are handed out dynamically one at a time,
+/// so unbalanced tasks keep all the threads busy till the end.
+///
+/// The calling thread participates in the work,
+/// and the function returns only after all the indices are processed.
+///
+/// @tparam F  Callable with the (int index) signature.
+///
+/// @param[in] num_threads  The maximum number of threads to use.
+/// @param[in] count  The number of tasks.
+/// @param[in] f  The task to run for each index.
+///
+/// @pre The tasks for different indices are independent.
+/// @pre The function does not throw.
+template <typename F>
+void parallel_for(int num_threads, int count, F&& f) noexcept {
+  num_threads = std::min(num_threads, count);
+  if (num_threads < 2) {
+    for (int i = 0; i < count; ++i)
+      f(i);
+    return;
+  }
+  std::atomic<int> next_index = 0;
+  auto worker = [&next_index, count, &f] {
+    for (int i = next_index++; i < count; i = next_index++)
+      f(i);
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (int i = 1; i < num_threads; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+}  // namespace ext
@@ -28,6 +28,7 @@
 
 #include "event.h"
 #include "logger.h"
+#include "pdag_cache.h"
 
 namespace scram::core {
 
@@ -78,15 +79,25 @@ double Product::p() const {
   return p;
 }
 
-std::vector<int> ProductContainer::Distribution() const {
-  std::vector<int> distribution;
-  for (const std::vector<int>& product : products_) {
-    int index = product.empty() ? 0 : product.size() - 1;
-    if (distribution.size() <= index)
-      distribution.resize(index + 1);
-    distribution[index]++;
+void ProductContainer::GatherStatistics() noexcept {
+  Pdag::IndexMap<bool> filter(graph_.basic_events().size());
+  auto it = begin().base();
+  for (auto it_end = end().base(); it != it_end; ++it) {
+    const std::vector<int>& result_set = *it;
+    ++size_;
+    int order = result_set.empty() ? 0 : result_set.size() - 1;
+    if (distribution_.size() <= order)
+      distribution_.resize(order + 1);
+    distribution_[order]++;
+    for (int i : result_set) {
+      i = std::abs(i);
+      if (filter[i])
+        continue;
+      filter[i] = true;
+      product_events_.insert(graph_.basic_events()[i]);
+    }
   }
-  return distribution;
+  truncated_p_ = products_.truncated_probability() + it.truncated_probability();
 }
 
 FaultTreeAnalysis::FaultTreeAnalysis(const mef::Gate& root,
@@ -95,14 +106,33 @@ FaultTreeAnalysis::FaultTreeAnalysis(const mef::Gate& root,
     : Analysis(settings), top_event_(root), model_(model) {}
 
 void FaultTreeAnalysis::Analyze() noexcept {
-  CLOCK(analysis_time);
-  graph_ = std::make_unique<Pdag>(top_event_,
-                                  Analysis::settings().ccf_analysis(), model_);
-  this->Preprocess(graph_.get());
+  CLOCK(preprocess_time);
+  auto graph = std::make_shared<Pdag>(
+      top_event_, Analysis::settings().ccf_analysis(), model_);
+  if (Analysis::settings().cache_dir().empty()) {
+    this->Preprocess(graph.get());
+  } else {
+    PdagCache cache(*graph, Analysis::settings());
+    if (auto cached_graph = cache.Load()) {
+      graph = std::move(cached_graph);
+    } else {
+      this->Preprocess(graph.get());
+      cache.Store(*graph);
+    }
+  }
 #ifndef NDEBUG
-  if (Analysis::settings().preprocessor)
+  if (Analysis::settings().preprocessor) {
+    graph_ = std::move(graph);
     return;  // Preprocessor only option.
+  }
 #endif
+  Analysis::AddAnalysisTime(DUR(preprocess_time));
+  AnalyzeGraph(std::move(graph));
+}
+
+void FaultTreeAnalysis::AnalyzeGraph(std::shared_ptr<Pdag> graph) noexcept {
+  CLOCK(analysis_time);
+  graph_ = std::move(graph);
   CLOCK(algo_time);
   LOG(DEBUG2) << "Launching the algorithm...";
   const Zbdd& products = this->GenerateProducts(graph_.get());
@@ -123,7 +153,11 @@ void FaultTreeAnalysis::Store(const Zbdd& products,
   } else if (products.base()) {
     Analysis::AddWarning("The set is UNITY/Base.");
   }
-  products_ = std::make_unique<const ProductContainer>(products, graph);
+  if (SelectProducts(products, graph)) {
+    Analysis::AddWarning(
+        "Only the " + std::to_string(Analysis::settings().top_products()) +
+        " most probable products are reported.");
+  }
 
 #ifndef NDEBUG
   for (const Product& product : *products_)
@@ -135,4 +169,31 @@ void FaultTreeAnalysis::Store(const Zbdd& products,
 #endif
 }
 
+bool FaultTreeAnalysis::SelectProducts(const Zbdd& products,
+                                       const Pdag& graph) noexcept {
+  int num_products = Analysis::settings().top_products();
+  if (!num_products) {
+    products_ = std::make_unique<const ProductContainer>(products, graph);
+    return false;
+  }
+  Pdag::IndexMap<double> p_vars;
+  p_vars.reserve(graph.basic_events().size());
+  for (const mef::BasicEvent* event : graph.basic_events())
+    p_vars.push_back(event->p());
+  // One extra product tells if any products are left out.
+  std::vector<std::vector<int>> selection =
+      products.FindTopProducts(num_products + 1, p_vars);
+  bool partial = selection.size() > num_products;
+  if (partial)
+    selection.pop_back();
+  products_ = std::make_unique<const ProductContainer>(
+      products, std::move(selection), graph);
+  return partial;
+}
+
+void FaultTreeAnalysis::Requantify() noexcept {
+  if (Analysis::settings().top_products())
+    SelectProducts(products_->zbdd(), *graph_);
+}
+
 }  // namespace scram::core
@@ -23,7 +23,9 @@
 #include <cstdlib>
 
 #include <memory>
+#include <optional>
 #include <unordered_set>
+#include <variant>
 #include <vector>
 
 #include <boost/iterator/iterator_facade.hpp>
@@ -106,6 +108,8 @@ class Product {
 
 /// A container of analysis result products with Literals.
 /// This is a wrapper of the analysis resultant ZBDD to work with Literals.
+/// Alternatively, the container may hold a selection of the products,
+/// e.g., the most probable products.
 class ProductContainer {
   /// Converter of analysis products with indices into products with literals.
   struct ProductExtractor {
@@ -118,23 +122,67 @@ class ProductContainer {
     const Pdag& graph;  ///< The host graph.
   };
 
+  /// Iterator over the products in the ZBDD or in the selection.
+  class const_iterator
+      : public boost::iterator_facade<const_iterator, const std::vector<int>,
+                                      boost::forward_traversal_tag> {
+    friend class boost::iterator_core_access;
+
+   public:
+    /// @param[in] it  The iterator over the ZBDD or the selection products.
+    template <class Iterator>
+    explicit const_iterator(Iterator it) : it_(std::move(it)) {}
+
+    /// @returns The truncated probability estimate
+    ///          of the products skipped by the ZBDD iterator so far.
+    double truncated_probability() const {
+      auto* it = std::get_if<Zbdd::const_iterator>(&it_);
+      return it ? it->truncated_probability() : 0;
+    }
+
+   private:
+    /// Standard forward iterator functionality returning products.
+    /// @{
+    void increment() {
+      std::visit([](auto& it) { ++it; }, it_);
+    }
+    bool equal(const const_iterator& other) const { return it_ == other.it_; }
+    const std::vector<int>& dereference() const {
+      return std::visit(
+          [](const auto& it) -> const std::vector<int>& { return *it; }, it_);
+    }
+    /// @}
+
+    /// The iterator over the products.
+    std::variant<Zbdd::const_iterator,
+                 std::vector<std::vector<int>>::const_iterator>
+        it_;
+  };
+
  public:
-  /// The constructor also collects basic events in products.
+  /// The constructor also collects basic events in products,
+  /// the product statistics, and the truncated probability
+  /// in a single pass over the products.
+  /// The products are not copied
+  /// but generated on the fly from the ZBDD by the iterators.
   ///
   /// @param[in] products  Sets with indices of events from calculations.
   /// @param[in] graph  PDAG with basic event indices and pointers.
   ProductContainer(const Zbdd& products, const Pdag& graph) noexcept
       : products_(products), graph_(graph) {
-    Pdag::IndexMap<bool> filter(graph_.basic_events().size());
-    for (const std::vector<int>& result_set : products_) {
-      for (int i : result_set) {
-        i = std::abs(i);
-        if (filter[i])
-          continue;
-        filter[i] = true;
-        product_events_.insert(graph_.basic_events()[i]);
-      }
-    }
+    GatherStatistics();
+  }
+
+  /// Wraps a selection of the analysis products.
+  ///
+  /// @param[in] products  Sets with indices of events from calculations.
+  /// @param[in] selection  The products selected from the results.
+  /// @param[in] graph  PDAG with basic event indices and pointers.
+  ProductContainer(const Zbdd& products,
+                   std::vector<std::vector<int>> selection,
+                   const Pdag& graph) noexcept
+      : products_(products), selection_(std::move(selection)), graph_(graph) {
+    GatherStatistics();
   }
 
   /// @returns Collection of basic events that are in the products.
@@ -145,29 +193,52 @@ class ProductContainer {
   /// Begin and end iterators over products in the container.
   /// @{
   auto begin() const {
-    return boost::make_transform_iterator(products_.begin(),
-                                          ProductExtractor{graph_});
+    return boost::make_transform_iterator(
+        selection_ ? const_iterator(selection_->begin())
+                   : const_iterator(products_.begin()),
+        ProductExtractor{graph_});
   }
   auto end() const {
-    return boost::make_transform_iterator(products_.end(),
-                                          ProductExtractor{graph_});
+    return boost::make_transform_iterator(
+        selection_ ? const_iterator(selection_->end())
+                   : const_iterator(products_.end()),
+        ProductExtractor{graph_});
   }
   /// @}
 
   /// @returns true if no products in the container.
-  bool empty() const { return products_.empty(); }
+  bool empty() const { return size_ == 0; }
 
   /// @returns The number of products in the container.
-  int size() const { return products_.size(); }
+  int size() const { return size_; }
 
   /// @returns The product distribution by order.
-  std::vector<int> Distribution() const;
+  const std::vector<int>& Distribution() const { return distribution_; }
+
+  /// @returns The analysis products of the container
+  ///          including the products not in the selection.
+  const Zbdd& zbdd() const { return products_; }
+
+  /// @returns The estimate of the total probability
+  ///          of the products discarded by the probability cut-off.
+  ///
+  /// @note With the selection of products,
+  ///       only the truncation in the construction of the ZBDD is included.
+  double truncated_probability() const { return truncated_p_; }
 
  private:
+  /// Collects the product events, count, and distribution.
+  void GatherStatistics() noexcept;
+
   const Zbdd& products_;  ///< Container of analysis results.
+  /// The optional selection of the products to use instead of all products.
+  std::optional<std::vector<std::vector<int>>> selection_;
   const Pdag& graph_;  ///< The analysis graph.
   /// The set of events in the resultant products.
   std::unordered_set<const mef::BasicEvent*> product_events_;
+  int size_ = 0;  ///< The number of products.
+  std::vector<int> distribution_;  ///< The number of products per order.
+  double truncated_p_ = 0;  ///< The estimate of the truncated probability.
 };
 
 /// Prints a collection of products to the standard error.
@@ -248,10 +319,24 @@ class FaultTreeAnalysis : public Analysis {
     return *products_;
   }
 
+  /// Updates the results dependent on the probabilities of the variables
+  /// (i.e., the selection of the most probable products)
+  /// with the current values of the model expressions.
+  ///
+  /// @pre The analysis is done.
+  void Requantify() noexcept;
+
  protected:
   /// @returns Pointer to the PDAG representing the fault tree.
   const Pdag* graph() const { return graph_.get(); }
 
+  /// Analyzes the fault tree with a PDAG
+  /// that has already been preprocessed for the analysis algorithm,
+  /// e.g., a graph shared by several analyses.
+  ///
+  /// @param[in] graph  The preprocessed PDAG containing the fault tree.
+  void AnalyzeGraph(std::shared_ptr<Pdag> graph) noexcept;
+
  private:
   /// Preprocesses a PDAG for future analysis with a specific algorithm.
   ///
@@ -277,9 +362,18 @@ class FaultTreeAnalysis : public Analysis {
   /// @param[in] graph  PDAG with basic event indices and pointers.
   void Store(const Zbdd& products, const Pdag& graph) noexcept;
 
+  /// Selects the products to store
+  /// according to the current variable probabilities if requested.
+  ///
+  /// @param[in] products  Sets with indices of events from calculations.
+  /// @param[in] graph  PDAG with basic event indices and pointers.
+  ///
+  /// @returns true if some products are left out of the selection.
+  bool SelectProducts(const Zbdd& products, const Pdag& graph) noexcept;
+
   const mef::Gate& top_event_;  ///< The root of the graph under analysis.
   const mef::Model* model_;  ///< The optional Model with substitutions.
-  std::unique_ptr<Pdag> graph_;  ///< PDAG of the fault tree.
+  std::shared_ptr<Pdag> graph_;  ///< PDAG of the fault tree.
   std::unique_ptr<const ProductContainer> products_;  ///< Container of results.
 };
 
@@ -291,8 +385,20 @@ template <class Algorithm>
 class FaultTreeAnalyzer : public FaultTreeAnalysis {
  public:
   using FaultTreeAnalysis::FaultTreeAnalysis;
+  using FaultTreeAnalysis::Analyze;
   using FaultTreeAnalysis::graph;  // Provide access to other analyses.
 
+  /// Analyzes the fault tree with the algorithm
+  /// that has already been constructed from a shared PDAG.
+  ///
+  /// @param[in] graph  The preprocessed PDAG shared by analyses.
+  /// @param[in] algorithm  The algorithm constructed for this analysis.
+  void Analyze(std::shared_ptr<Pdag> graph,
+               std::unique_ptr<Algorithm> algorithm) noexcept {
+    algorithm_ = std::move(algorithm);
+    FaultTreeAnalysis::AnalyzeGraph(std::move(graph));
+  }
+
   /// @returns The analysis algorithm for use by other analyses.
   /// @{
   const Algorithm* algorithm() const { return algorithm_.get(); }
@@ -301,11 +407,12 @@ class FaultTreeAnalyzer : public FaultTreeAnalysis {
 
  private:
   void Preprocess(Pdag* graph) noexcept override {
-    CustomPreprocessor<Algorithm>{graph}();
+    CustomPreprocessor<Algorithm>{graph, Analysis::settings()}();
   }
 
   const Zbdd& GenerateProducts(const Pdag* graph) noexcept override {
-    algorithm_ = std::make_unique<Algorithm>(graph, Analysis::settings());
+    if (!algorithm_)
+      algorithm_ = std::make_unique<Algorithm>(graph, Analysis::settings());
     algorithm_->Analyze(graph);
     return algorithm_->products();
   }
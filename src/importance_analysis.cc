@@ -40,6 +40,7 @@ void ImportanceAnalysis::Analyze() noexcept {
       this->basic_events();
 
   std::vector<int> occurrences = this->occurrences();
+  std::vector<double> mifs = this->CalculateMifs(occurrences);
   for (int i = 0; i < basic_events.size(); ++i) {
     if (occurrences[i] == 0)
       continue;
@@ -47,7 +48,7 @@ void ImportanceAnalysis::Analyze() noexcept {
     double p_var = event.p();
     ImportanceFactors imp{};
     imp.occurrence = occurrences[i];
-    imp.mif = this->CalculateMif(i);
+    imp.mif = mifs[i];
     if (p_total != 0) {
       imp.cif = p_var * imp.mif / p_total;
       imp.raw = 1 + (1 - p_var) * imp.mif / p_total;
@@ -70,78 +71,18 @@ std::vector<int> ImportanceAnalyzerBase::occurrences() noexcept {
   return result;
 }
 
-double ImportanceAnalyzer<Bdd>::CalculateMif(int index) noexcept {
-  index += Pdag::kVariableStartIndex;
-  const Bdd::VertexPtr& root = bdd_graph_->root().vertex;
-  if (root->terminal())
-    return 0;
-  bool original_mark = Ite::Ref(root).mark();
-
-  int order = bdd_graph_->index_to_order().find(index)->second;
-  double mif = CalculateMif(root, order, !original_mark);
-  bdd_graph_->ClearMarks(original_mark);
-  return mif;
-}
-
-double ImportanceAnalyzer<Bdd>::CalculateMif(const Bdd::VertexPtr& vertex,
-                                             int order, bool mark) noexcept {
-  if (vertex->terminal())
-    return 0;
-  Ite& ite = Ite::Ref(vertex);
-  if (ite.mark() == mark)
-    return ite.factor();
-  ite.mark(mark);
-  if (ite.order() > order) {
-    if (!ite.module()) {
-      ite.factor(0);
-    } else {  /// @todo Detect if the variable is in the module.
-      // The assumption is
-      // that the order of a module is always larger
-      // than the order of its variables.
-      double high = RetrieveProbability(ite.high());
-      double low = RetrieveProbability(ite.low());
-      if (ite.complement_edge())
-        low = 1 - low;
-      const Bdd::Function& res =
-          bdd_graph_->modules().find(ite.index())->second;
-      double mif = CalculateMif(res.vertex, order, mark);
-      if (res.complement)
-        mif = -mif;
-      ite.factor((high - low) * mif);
-    }
-  } else if (ite.order() == order) {
-    assert(!ite.module() && "A variable can't be a module.");
-    double high = RetrieveProbability(ite.high());
-    double low = RetrieveProbability(ite.low());
-    if (ite.complement_edge())
-      low = 1 - low;
-    ite.factor(high - low);
-  } else {
-    assert(ite.order() < order);
-    double p_var = 0;
-    if (ite.module()) {
-      const Bdd::Function& res =
-          bdd_graph_->modules().find(ite.index())->second;
-      p_var = RetrieveProbability(res.vertex);
-      if (res.complement)
-        p_var = 1 - p_var;
-    } else {
-      p_var = prob_analyzer()->p_vars()[ite.index()];
-    }
-    double high = CalculateMif(ite.high(), order, mark);
-    double low = CalculateMif(ite.low(), order, mark);
-    if (ite.complement_edge())
-      low = -low;
-    ite.factor(p_var * high + (1 - p_var) * low);
-  }
-  return ite.factor();
-}
-
-double ImportanceAnalyzer<Bdd>::RetrieveProbability(
-    const Bdd::VertexPtr& vertex) noexcept {
-  if (vertex->terminal())
-    return 1;
-  return Ite::Ref(vertex).p();
+std::vector<double> ImportanceAnalyzer<Bdd>::CalculateMifs(
+    const std::vector<int>& occurrences) noexcept {
+  std::vector<double> mifs(occurrences.size());
+  if (bdd_graph_->root().vertex->terminal())
+    return mifs;
+  const double* p_vars = prob_analyzer()->p_vars().data();
+  std::vector<double> values;
+  double p_total = 0;
+  flat_bdd_.Calculate(p_vars, 1, &values, &p_total);
+  std::vector<double> adjoints;
+  flat_bdd_.CalculateMifs(p_vars, values, &adjoints, &mifs);
+  return mifs;
 }
 
 }  // namespace scram::core
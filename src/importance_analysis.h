@@ -85,12 +85,14 @@ class ImportanceAnalysis : public Analysis {
   /// @returns Occurrences of basic events in products.
   virtual std::vector<int> occurrences() noexcept = 0;
 
-  /// Calculates Marginal Importance Factor.
+  /// Calculates Marginal Importance Factors of events.
   ///
-  /// @param[in] index  The position index of an event in events vector.
+  /// @param[in] occurrences  The occurrences of events in products.
   ///
-  /// @returns Calculated value for MIF.
-  virtual double CalculateMif(int index) noexcept = 0;
+  /// @returns Calculated values for MIF in the order of events.
+  ///          The factors of events without occurrences are unspecified.
+  virtual std::vector<double>
+  CalculateMifs(const std::vector<int>& occurrences) noexcept = 0;
 
   /// Container of important events and their importance factors.
   std::vector<ImportanceRecord> importance_;
@@ -134,28 +136,20 @@ class ImportanceAnalyzer : public ImportanceAnalyzerBase {
  public:
   /// @copydoc ImportanceAnalyzerBase::ImportanceAnalyzerBase
   explicit ImportanceAnalyzer(ProbabilityAnalyzer<Calculator>* prob_analyzer)
-      : ImportanceAnalyzerBase(prob_analyzer),
-        p_vars_(prob_analyzer->p_vars()) {}
+      : ImportanceAnalyzerBase(prob_analyzer) {}
 
  private:
-  double CalculateMif(int index) noexcept override;
-  Pdag::IndexMap<double> p_vars_;  ///< A copy of variable probabilities.
+  /// Calculates the factors of all variables
+  /// in a single sweep over the products with the calculator.
+  std::vector<double>
+  CalculateMifs(const std::vector<int>& /*occurrences*/) noexcept override {
+    Pdag::IndexMap<double> mifs;
+    static_cast<ProbabilityAnalyzer<Calculator>*>(prob_analyzer())
+        ->CalculateMifs(&mifs);
+    return std::move(mifs);
+  }
 };
 
-template <class Calculator>
-double ImportanceAnalyzer<Calculator>::CalculateMif(int index) noexcept {
-  index += Pdag::kVariableStartIndex;
-  auto p_conditional = [index, this](bool state) {
-    p_vars_[index] = state;
-    return static_cast<ProbabilityAnalyzer<Calculator>*>(prob_analyzer())
-        ->CalculateTotalProbability(p_vars_);
-  };
-  double p_store = p_vars_[index];  // Save the original value for restoring.
-  double mif = p_conditional(true) - p_conditional(false);
-  p_vars_[index] = p_store;  // Restore the probability for next calculation.
-  return mif;
-}
-
 /// Specialization of importance analyzer with Binary Decision Diagrams.
 template <>
 class ImportanceAnalyzer<Bdd> : public ImportanceAnalyzerBase {
@@ -167,33 +161,18 @@ class ImportanceAnalyzer<Bdd> : public ImportanceAnalyzerBase {
   /// @param[in] prob_analyzer  Instantiated probability analyzer.
   explicit ImportanceAnalyzer(ProbabilityAnalyzer<Bdd>* prob_analyzer)
       : ImportanceAnalyzerBase(prob_analyzer),
-        bdd_graph_(prob_analyzer->bdd_graph()) {}
+        bdd_graph_(prob_analyzer->bdd_graph()),
+        flat_bdd_(prob_analyzer->flat_bdd()) {}
 
  private:
-  double CalculateMif(int index) noexcept override;
-
-  /// Calculates Marginal Importance Factor of a variable.
-  ///
-  /// @param[in] vertex  The root vertex of a function graph.
-  /// @param[in] order  The identifying order of the variable.
-  /// @param[in] mark  A flag to mark traversed vertices.
-  ///
-  /// @returns Importance factor value.
-  ///
-  /// @note Probability factor fields are used to save results.
-  /// @note The graph needs cleaning its marks after this function
-  ///       because the graph gets continuously-but-partially marked.
-  double CalculateMif(const Bdd::VertexPtr& vertex, int order,
-                      bool mark) noexcept;
-
-  /// Retrieves memorized probability values for BDD function graphs.
-  ///
-  /// @param[in] vertex  Vertex with calculated probabilities.
-  ///
-  /// @returns Saved probability value of the vertex.
-  double RetrieveProbability(const Bdd::VertexPtr& vertex) noexcept;
+  /// Calculates the factors of all variables
+  /// in a forward sweep for the probabilities of the BDD vertices
+  /// and a backward sweep for the partial derivatives.
+  std::vector<double>
+  CalculateMifs(const std::vector<int>& occurrences) noexcept override;
 
   Bdd* bdd_graph_;  ///< Binary decision diagram for the analyzer.
+  const FlatBdd& flat_bdd_;  ///< The BDD copy for calculations.
 };
 
 }  // namespace scram::core
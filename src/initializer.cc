@@ -20,7 +20,9 @@
 
 #include "initializer.h"
 
+#include <exception>
 #include <functional>  // std::mem_fn
+#include <optional>
 #include <sstream>
 #include <type_traits>
 
@@ -42,6 +44,7 @@
 #include "expression/test_event.h"
 #include "ext/algorithm.h"
 #include "ext/find_iterator.h"
+#include "ext/parallel.h"
 #include "logger.h"
 
 namespace scram::mef {
@@ -154,9 +157,13 @@ PhasePtr ConstructElement<Phase>(const xml::Element& xml_element) {
 }  // namespace
 
 Initializer::Initializer(const std::vector<std::string>& xml_files,
-                         core::Settings settings, bool allow_extern)
-    : settings_(std::move(settings)), allow_extern_(allow_extern) {
+                         core::Settings settings, bool allow_extern,
+                         bool trusted_input)
+    : settings_(std::move(settings)),
+      allow_extern_(allow_extern),
+      trusted_input_(trusted_input) {
   BLOG(WARNING, allow_extern_) << "Enabling external dynamic libraries";
+  BLOG(WARNING, trusted_input_) << "Skipping the input schema validation";
   ProcessInputFiles(xml_files);
 }
 
@@ -205,11 +212,34 @@ void Initializer::ProcessInputFiles(const std::vector<std::string>& xml_files) {
   LOG(DEBUG1) << "Processing input files";
   CheckFileExistence(xml_files);
   CheckDuplicateFiles(xml_files);
-  for (const auto& xml_file : xml_files) {
+  // The files are parsed and validated concurrently
+  // but registered sequentially in the original order
+  // to keep the error reporting the same as with sequential processing.
+  std::vector<std::optional<xml::Document>> documents(xml_files.size());
+  std::vector<std::exception_ptr> errors(xml_files.size());
+  CLOCK(parse_time);
+  xmlInitParser();  // Must be called before parsing in multiple threads.
+  ext::parallel_for(settings_.jobs(), xml_files.size(), [&](int i) {
+    try {
+      if (trusted_input_) {
+        documents[i].emplace(xml_files[i]);
+      } else {
+        static const xml::Validator validator(env::input_schema());
+        xml::Validator thread_validator(validator);
+        documents[i].emplace(xml_files[i], &thread_validator);
+      }
+    } catch (...) {
+      errors[i] = std::current_exception();
+    }
+  });
+  LOG(DEBUG2) << "Parsed the input files in " << DUR(parse_time);
+  for (int i = 0; i < xml_files.size(); ++i) {
     try {
-      ProcessInputFile(xml_file);
+      if (errors[i])
+        std::rethrow_exception(errors[i]);
+      ProcessInputFile(xml_files[i], std::move(*documents[i]));
     } catch (ValidityError& err) {
-      err << boost::errinfo_file_name(xml_file);
+      err << boost::errinfo_file_name(xml_files[i]);
       throw;
     }
   }
@@ -347,14 +377,9 @@ Sequence* Initializer::Register(const xml::Element& xml_node,
 }
 /// @}
 
-void Initializer::ProcessInputFile(const std::string& xml_file) {
-  static xml::Validator validator(env::input_schema());
-
-  CLOCK(parse_time);
-  LOG(DEBUG3) << "Parsing " << xml_file << " ...";
-  xml::Document document(xml_file, &validator);
-  LOG(DEBUG3) << "Parsed " << xml_file << " in " << DUR(parse_time);
-
+void Initializer::ProcessInputFile(const std::string& xml_file,
+                                   xml::Document document) {
+  LOG(DEBUG3) << "Processing " << xml_file << " ...";
   xml::Element root = document.root();
   assert(root.name() == "opsa-mef");
 
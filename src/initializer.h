@@ -65,6 +65,7 @@ class Initializer : private boost::noncopyable {
   /// @param[in] xml_files  The MEF XML input files.
   /// @param[in] settings  Analysis settings.
   /// @param[in] allow_extern  Allow external libraries in the input.
+  /// @param[in] trusted_input  Skip the schema validation of the input.
   ///
   /// @throws DuplicateArgumentError  Input contains duplicate files.
   /// @throws ValidityError  The input contains errors.
@@ -73,13 +74,19 @@ class Initializer : private boost::noncopyable {
   /// @warning Processing external libraries from XML input is **UNSAFE**.
   ///          It allows loading and executing arbitrary code during analysis.
   ///          Enable this feature for trusted input files and libraries only.
+  ///
+  /// @warning The initialization relies on the schema validation
+  ///          to reject malformed input structures.
+  ///          Skip the validation only for input files
+  ///          that are known to be valid (e.g., generated or checked before).
   Initializer(const std::vector<std::string>& xml_files,
-              core::Settings settings, bool allow_extern = false);
+              core::Settings settings, bool allow_extern = false,
+              bool trusted_input = false);
 
   /// @returns The model built from the input files.
   std::shared_ptr<Model> model() const { return model_; }
 
-  /// @returns The parsed & validated XML DOM documents
+  /// @returns The parsed & validated (unless trusted) XML DOM documents
   ///          corresponding to the input files (the same order).
   const std::vector<xml::Document>& documents() const { return documents_; }
 
@@ -152,7 +159,7 @@ class Initializer : private boost::noncopyable {
   /// @throws IOError  One of the input files is not accessible.
   void ProcessInputFiles(const std::vector<std::string>& xml_files);
 
-  /// Reads one input file with the structure of analysis entities.
+  /// Registers the structure of analysis entities from one input file.
   /// Initializes the analysis from the given input file.
   /// Puts all events into their appropriate containers.
   /// This function mostly registers element definitions,
@@ -160,13 +167,13 @@ class Initializer : private boost::noncopyable {
   /// because of possible undefined dependencies of those elements.
   ///
   /// @param[in] xml_file  The formatted XML input file.
+  /// @param[in] document  The parsed and validated document of the file.
   ///
   /// @pre The input file has not been passed before.
   ///
   /// @throws ValidityError  The input contains errors.
-  /// @throws IOError  The input file is not accessible.
   /// @throws IllegalOperation  Loading external libraries is disallowed.
-  void ProcessInputFile(const std::string& xml_file);
+  void ProcessInputFile(const std::string& xml_file, xml::Document document);
 
   /// Processes definitions of elements
   /// that are left to be determined later.
@@ -491,6 +498,7 @@ class Initializer : private boost::noncopyable {
   std::shared_ptr<Model> model_;  ///< Analysis model with constructs.
   core::Settings settings_;  ///< Settings for analysis.
   bool allow_extern_;  ///< Allow processing MEF 'extern-library'.
+  bool trusted_input_;  ///< Skip the schema validation of the input.
 
   /// Saved XML documents to keep elements alive.
   std::vector<xml::Document> documents_;
@@ -32,7 +32,9 @@
 namespace scram::core {
 
 Mocus::Mocus(const Pdag* graph, const Settings& settings)
-    : graph_(graph), kSettings_(settings) {
+    : graph_(graph),
+      kSettings_(settings),
+      weights_(ProbabilityWeights::Create(*graph, settings)) {
   assert(!graph->complement() && "Complements must be propagated.");
 }
 
@@ -44,13 +46,15 @@ void Mocus::Analyze(const Pdag*) noexcept {
   }
 
   TIMER(DEBUG2, "Minimal cut set generation");
-  zbdd_ = AnalyzeModule(graph_->root(), kSettings_);
+  zbdd_ = AnalyzeModule(graph_->root(), kSettings_,
+                        weights_ ? weights_->limit() : 0);
   LOG(DEBUG2) << "Delegating cut set extraction to ZBDD.";
   zbdd_->Analyze(graph_);
 }
 
 std::unique_ptr<zbdd::CutSetContainer>
-Mocus::AnalyzeModule(const Gate& gate, const Settings& settings) noexcept {
+Mocus::AnalyzeModule(const Gate& gate, const Settings& settings,
+                     int limit_weight) noexcept {
   assert(gate.module() && "Expected only module gates.");
   CLOCK(gen_time);
   LOG(DEBUG3) << "Finding cut sets from module: G" << gate.index();
@@ -64,7 +68,7 @@ Mocus::AnalyzeModule(const Gate& gate, const Settings& settings) noexcept {
   const int kMaxVariableIndex =
       Pdag::kVariableStartIndex + graph_->basic_events().size() - 1;
   auto container = std::make_unique<zbdd::CutSetContainer>(
-      kSettings_, gate.index(), kMaxVariableIndex);
+      kSettings_, gate.index(), kMaxVariableIndex, weights_, limit_weight);
   container->Merge(container->ConvertGate(gate));
   while (int next_gate_index = container->GetNextGate()) {
     LOG(DEBUG5) << "Expanding gate G" << next_gate_index;
@@ -83,23 +87,31 @@ Mocus::AnalyzeModule(const Gate& gate, const Settings& settings) noexcept {
     container->EliminateComplements();
     container->Minimize();
   }
+  std::vector<std::pair<int, Zbdd::ModuleLimits>> modules;
   for (const auto& entry : container->GatherModules()) {
     int index = entry.first;
     assert(index > 0 && "No complement modules are expected.");
-    int limit = entry.second.second;
-    assert(limit >= 0 && "Order cut-off is not strict.");
-    bool coherent = entry.second.first;
-    if (limit == 0 && coherent) {  // Unity is impossible.
+    const Zbdd::ModuleLimits& limits = entry.second;
+    assert(limits.order >= 0 && "Order cut-off is not strict.");
+    if (limits.order == 0 && limits.coherent) {  // Unity is impossible.
       auto empty_zbdd = std::make_unique<zbdd::CutSetContainer>(
           kSettings_, index, kMaxVariableIndex);
       container->JoinModule(index, std::move(empty_zbdd));
       continue;
     }
-    Settings adjusted(settings);
-    adjusted.limit_order(limit);
-    container->JoinModule(index,
-                          AnalyzeModule(*gates.find(index)->second, adjusted));
+    modules.emplace_back(index, limits);
   }
+  // Independent modules share no variables; each gets its own container.
+  std::vector<std::unique_ptr<zbdd::CutSetContainer>> results =
+      zbdd::AnalyzeModules<zbdd::CutSetContainer>(
+          modules, settings,
+          [this, &gates](int index, const Zbdd::ModuleLimits& limits,
+                         const Settings& adjusted) {
+            return AnalyzeModule(*gates.find(index)->second, adjusted,
+                                 limits.weight);
+          });
+  for (int i = 0; i < modules.size(); ++i)
+    container->JoinModule(modules[i].first, std::move(results[i]));
   container->EliminateConstantModules();
   container->Minimize();
   return container;
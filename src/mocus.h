@@ -67,13 +67,17 @@ class Mocus : private boost::noncopyable {
   ///
   /// @param[in] gate  A PDAG gate for analysis.
   /// @param[in] settings  Settings for analysis.
+  /// @param[in] limit_weight  The limit on the weight of products.
   ///
   /// @returns Fully processed, minimized Zbdd cut set container.
   std::unique_ptr<zbdd::CutSetContainer>
-  AnalyzeModule(const Gate& gate, const Settings& settings) noexcept;
+  AnalyzeModule(const Gate& gate, const Settings& settings,
+                int limit_weight) noexcept;
 
   const Pdag* graph_;  ///< The analysis PDAG.
   const Settings kSettings_;  ///< Analysis settings.
+  /// The literal weights for the probability cut-off if any.
+  std::shared_ptr<const ProbabilityWeights> weights_;
   std::unique_ptr<Zbdd> zbdd_;  ///< ZBDD as a result of analysis.
 };
 
@@ -20,6 +20,8 @@
 
 #include "parameter.h"
 
+#include <utility>
+
 #include "error.h"
 
 namespace scram::mef {
@@ -41,4 +43,11 @@ void Parameter::expression(Expression* expression) {
   Expression::AddArg(expression);
 }
 
+Expression* Parameter::ReplaceExpression(Expression* expression) {
+  if (!expression_)
+    SCRAM_THROW(LogicError("Parameter expression is not set."));
+  Expression::ReplaceArg(expression_, expression);
+  return std::exchange(expression_, expression);
+}
+
 }  // namespace scram::mef
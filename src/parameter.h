@@ -95,6 +95,16 @@ class Parameter : public Expression, public Id, public NodeMark, public Usage {
   /// @throws LogicError  The parameter expression is already set.
   void expression(Expression* expression);
 
+  /// Replaces the expression of this parameter,
+  /// e.g., to re-evaluate the model with a different parameter value.
+  ///
+  /// @param[in] expression  The new expression without cycles.
+  ///
+  /// @returns The replaced expression.
+  ///
+  /// @throws LogicError  The parameter expression is not set.
+  Expression* ReplaceExpression(Expression* expression);
+
   /// @returns The unit of this parameter.
   Units unit() const { return unit_; }
 
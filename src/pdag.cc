@@ -25,12 +25,16 @@
 
 #include "pdag.h"
 
+#include <algorithm>
 #include <iostream>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <boost/math/special_functions/sign.hpp>
 #include <boost/range/algorithm.hpp>
+#include <boost/range/algorithm_ext.hpp>
 
 #include "event.h"
 #include "ext/algorithm.h"
@@ -196,6 +200,27 @@ void Gate::ShareArg(int index, const GatePtr& recipient) noexcept {
   }
 }
 
+void Gate::ShareArgs(const std::vector<int>& indices,
+                     const GatePtr& recipient) noexcept {
+  assert(!constant() && "Improper use case.");
+  assert(boost::is_sorted(indices));
+  auto share = [&indices, &recipient](const auto& args) {
+    using ArgType = typename std::decay_t<decltype(args)>::value_type;
+    std::vector<const ArgType*> shared_args;
+    for (const ArgType& arg : args) {
+      if (std::binary_search(indices.begin(), indices.end(), arg.first))
+        shared_args.push_back(&arg);
+    }
+    boost::sort(shared_args, [](const ArgType* lhs, const ArgType* rhs) {
+      return lhs->first < rhs->first;
+    });
+    for (const ArgType* arg : shared_args)
+      recipient->AddArg(*arg);
+  };
+  share(gate_args_);
+  share(variable_args_);
+}
+
 void Gate::NegateArgs() noexcept {
   /* assert(!constant() && "Improper use case."); */
   /// @todo Consider in place inversion.
@@ -304,6 +329,40 @@ void Gate::EraseArg(int index) noexcept {
   }
 }
 
+void Gate::EraseArgs(const std::vector<int>& indices) noexcept {
+  assert(!constant() && "Improper use case.");
+  assert(boost::is_sorted(indices));
+  ArgSet::sequence_type remaining_args = args_.extract_sequence();
+  boost::remove_erase_if(remaining_args, [&indices](int index) {
+    return std::binary_search(indices.begin(), indices.end(), index);
+  });
+  args_.adopt_sequence(boost::container::ordered_unique_range,
+                       std::move(remaining_args));
+
+  // The last argument is moved into the place of the erased argument.
+  auto erase = [this, &indices](auto* args) {
+    auto& data = args->data();
+    std::unordered_map<int, int> positions;
+    for (int i = 0; i < data.size(); ++i)
+      positions.emplace(data[i].first, i);
+    for (int index : indices) {
+      auto it = positions.find(index);
+      if (it == positions.end())
+        continue;  // Another type of argument.
+      int position = it->second;
+      positions.erase(it);
+      data[position].second->EraseParent(Node::index());
+      if (position != data.size() - 1) {
+        data[position] = std::move(data.back());
+        positions[data[position].first] = position;
+      }
+      data.pop_back();
+    }
+  };
+  erase(&gate_args_);
+  erase(&variable_args_);
+}
+
 void Gate::EraseArgs() noexcept {
   args_.clear();
   for (const auto& arg : gate_args_)
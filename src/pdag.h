@@ -585,6 +585,17 @@ class Gate : public Node, public std::enable_shared_from_this<Gate> {
   /// @pre No constant arguments are present.
   void ShareArg(int index, const GatePtr& recipient) noexcept;
 
+  /// Shares multiple arguments of this gate with another gate.
+  /// The result is the same as the sequential ShareArg calls
+  /// without the searches for every argument.
+  ///
+  /// @param[in] indices  Sorted positive or negative indices of the arguments.
+  /// @param[in,out] recipient  Another parent for the arguments.
+  ///
+  /// @pre No constant arguments are present.
+  void ShareArgs(const std::vector<int>& indices,
+                 const GatePtr& recipient) noexcept;
+
   /// Makes all arguments complements of themselves.
   /// This is a helper function to propagate a complement gate
   /// and apply the De Morgan's Law.
@@ -669,6 +680,18 @@ class Gate : public Node, public std::enable_shared_from_this<Gate> {
   ///          which must be handled by the caller.
   void EraseArg(int index) noexcept;
 
+  /// Removes multiple arguments from the arguments container.
+  /// The result is the same as the sequential EraseArg calls
+  /// in the order of the indices
+  /// without the searches for every argument.
+  ///
+  /// @param[in] indices  Sorted positive or negative indices
+  ///                     of the existing non-constant arguments.
+  ///
+  /// @warning The parent gate may become empty or one-argument gate,
+  ///          which must be handled by the caller.
+  void EraseArgs(const std::vector<int>& indices) noexcept;
+
   /// Clears all the arguments of this gate.
   void EraseArgs() noexcept;
 
@@ -778,6 +801,8 @@ void Gate::AddArg<Constant>(int index, const ConstantPtr& arg) noexcept;
 ///      which is not the assumption of
 ///      all the other preprocessing and analysis algorithms.
 class Pdag : private boost::noncopyable {
+  friend class PdagCache;  // Restoration of preprocessed graphs.
+
  public:
   static const int kVariableStartIndex = 2;  ///< The shift value for mapping.
   /// Sequential mapping of Variable indices to other data of type T.
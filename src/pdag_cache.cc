@@ -0,0 +1,356 @@
+/*
+ * Copyright (C) 2018 Olzhas Rakhimov
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// Implementation of the PDAG cache.
+///
+/// The cache file layout (in the byte order of the writer):
+///
+///   - Header
+///   - char key material[key_size]
+///   - int32 variable orders[num_variables]
+///   - Gate records in post-order (arguments before parents):
+///       int32 index, uint8 type, uint8 flags,
+///       int32 vote number, int32 order,
+///       uint32 num_args, int32 signed argument indices[num_args].
+///
+/// The argument indices of variables and the constant
+/// are the same as in the original graph;
+/// the gate indices refer to the previously recorded gates.
+///
+/// The key material is the canonical serialization of the original graph
+/// and settings hashed into the file name.
+/// It is compared byte-by-byte on load
+/// so that hash collisions cannot substitute a foreign graph.
+
+#include "pdag_cache.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <memory>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "event.h"
+#include "logger.h"
+#include "version.h"
+
+namespace fs = boost::filesystem;
+
+namespace scram::core {
+
+namespace {
+
+/// The file signature.
+const char kMagic[8] = {'S', 'C', 'R', 'A', 'M', 'P', 'D', 'G'};
+/// The version of the layout and the hash.
+const std::uint32_t kVersion = 2;
+
+/// The cache file header.
+struct Header {
+  char magic[8];  ///< kMagic.
+  std::uint32_t version;  ///< kVersion.
+  std::uint32_t flags;  ///< The complement, coherent, normal graph flags.
+  std::uint64_t key;  ///< The key of the original graph.
+  std::uint64_t key_size;  ///< The size of the key material.
+  std::uint32_t num_variables;  ///< The number of variables in the graph.
+  std::int32_t root;  ///< The index of the root gate.
+};
+
+/// The graph flags.
+/// @{
+const std::uint32_t kComplement = 1;
+const std::uint32_t kCoherent = 2;
+const std::uint32_t kNormal = 4;
+/// @}
+
+/// The gate flags.
+/// @{
+const std::uint8_t kModule = 1;
+const std::uint8_t kGateCoherent = 2;
+/// @}
+
+/// Accumulator of the canonical key material.
+class KeyBuilder {
+ public:
+  /// Appends raw bytes to the key.
+  void Add(const void* data, std::size_t size) {
+    material_.append(static_cast<const char*>(data), size);
+  }
+
+  /// Appends an integer to the key.
+  void Add(std::int64_t number) { Add(&number, sizeof(number)); }
+
+  /// Appends a NUL-terminated string to the key.
+  void Add(const char* str) { Add(str, std::strlen(str) + 1); }
+
+  /// @returns The accumulated key material.
+  std::string& material() { return material_; }
+
+ private:
+  std::string material_;  ///< The serialized key.
+};
+
+/// @returns The 64-bit FNV-1a hash of the bytes.
+std::uint64_t Hash(const std::string& bytes) {
+  std::uint64_t value = 0xcbf29ce484222325;  // The offset basis.
+  for (unsigned char byte : bytes) {
+    value ^= byte;
+    value *= 0x100000001b3;
+  }
+  return value;
+}
+
+/// Writes a value into the file.
+template <typename T>
+bool Write(const T& value, std::FILE* file) {
+  return std::fwrite(&value, sizeof(value), 1, file) == 1;
+}
+
+/// Reads a value from the file.
+template <typename T>
+bool Read(T* value, std::FILE* file) {
+  return std::fread(value, sizeof(*value), 1, file) == 1;
+}
+
+/// Closes the file upon destruction.
+struct FileCloser {
+  /// @param[in] file  The open file.
+  void operator()(std::FILE* file) const { std::fclose(file); }
+};
+
+/// Owner of the open file.
+using FilePtr = std::unique_ptr<std::FILE, FileCloser>;
+
+}  // namespace
+
+PdagCache::PdagCache(const Pdag& graph, const Settings& settings) noexcept
+    : graph_(graph) {
+  KeyBuilder key;
+  key.Add(kVersion);
+  key.Add(version::describe());
+  key.Add(static_cast<int>(settings.algorithm()));
+  key.Add(settings.prime_implicants());
+  key.Add(static_cast<int>(settings.variable_order()));
+
+  key.Add(graph.basic_events().size());
+  for (const mef::BasicEvent* event : graph.basic_events())
+    key.Add(event->id().c_str());
+
+  std::unordered_set<int> visited;
+  auto add_gate = [&key, &visited](auto& self, const Gate& gate) -> void {
+    if (!visited.insert(gate.index()).second)
+      return;
+    for (const auto& arg : gate.args<Gate>())
+      self(self, arg.second);
+    key.Add(gate.index());
+    key.Add(gate.type());
+    key.Add(gate.vote_number());
+    key.Add(gate.args().size());
+    for (int index : gate.args())
+      key.Add(index);
+  };
+  add_gate(add_gate, graph.root());
+  key.Add(graph.complement());
+  key.Add(graph.coherent());
+  key.Add(graph.normal());
+
+  for (const Pdag::Substitution& substitution : graph.substitutions()) {
+    key.Add(substitution.target);
+    key.Add(substitution.hypothesis.size());
+    for (int index : substitution.hypothesis)
+      key.Add(index);
+    key.Add(substitution.source.size());
+    for (int index : substitution.source)
+      key.Add(index);
+  }
+
+  key_material_ = std::move(key.material());
+  key_ = Hash(key_material_);
+  std::stringstream name;
+  name << std::hex << key_ << ".pdag";
+  path_ = (fs::path(settings.cache_dir()) / name.str()).string();
+}
+
+std::shared_ptr<Pdag> PdagCache::Load() noexcept {
+  FilePtr file(std::fopen(path_.c_str(), "rb"));
+  if (!file) {
+    LOG(DEBUG2) << "No cached PDAG: " << path_;
+    return nullptr;
+  }
+  auto invalid = [this] {
+    LOG(WARNING) << "Ignoring the invalid PDAG cache file: " << path_;
+    return nullptr;
+  };
+  Header header;
+  if (!Read(&header, file.get()) ||
+      std::memcmp(header.magic, kMagic, sizeof(kMagic)) ||
+      header.version != kVersion || header.key != key_ ||
+      header.key_size != key_material_.size() ||
+      header.num_variables != graph_.basic_events().size())
+    return invalid();
+  std::string key_material(key_material_.size(), '\0');
+  if (std::fread(key_material.data(), 1, key_material.size(), file.get()) !=
+          key_material.size() ||
+      key_material != key_material_)
+    return invalid();
+
+  auto graph = std::make_shared<Pdag>();
+  graph->basic_events_ = graph_.basic_events_;
+  for (const Pdag::Substitution& substitution : graph_.substitutions_)
+    graph->substitutions_.push_back(substitution);
+  graph->register_null_gates_ = false;  // Constant gates are expected.
+  graph->complement() = header.flags & kComplement;
+  graph->coherent(header.flags & kCoherent);
+  graph->normal(header.flags & kNormal);
+
+  std::vector<VariablePtr> variables;
+  for (std::uint32_t i = 0; i < header.num_variables; ++i) {
+    std::int32_t order;
+    if (!Read(&order, file.get()))
+      return invalid();
+    variables.push_back(std::make_shared<Variable>(graph.get()));
+    variables.back()->order(order);
+  }
+  int max_variable = Pdag::kVariableStartIndex + header.num_variables - 1;
+
+  std::unordered_map<int, GatePtr> gates;  // Original indices to new gates.
+  std::int32_t index;
+  while (Read(&index, file.get())) {
+    std::uint8_t type;
+    std::uint8_t flags;
+    std::int32_t vote_number;
+    std::int32_t order;
+    std::uint32_t num_args;
+    if (!Read(&type, file.get()) || type >= kNumOperators ||
+        !Read(&flags, file.get()) || !Read(&vote_number, file.get()) ||
+        !Read(&order, file.get()) || !Read(&num_args, file.get()) ||
+        gates.count(index))
+      return invalid();
+
+    auto gate = std::make_shared<Gate>(static_cast<Operator>(type),
+                                       graph.get());
+    gate->vote_number(vote_number);
+    for (std::uint32_t i = 0; i < num_args; ++i) {
+      std::int32_t arg;
+      if (!Read(&arg, file.get()) || !arg)
+        return invalid();
+      int arg_index = std::abs(arg);
+      if (arg_index == 1) {
+        gate->AddArg(arg, graph->constant());
+      } else if (arg_index <= max_variable) {
+        gate->AddArg(arg, variables[arg_index - Pdag::kVariableStartIndex]);
+      } else if (auto it = gates.find(arg_index); it != gates.end()) {
+        gate->AddArg(arg > 0 ? it->second->index() : -it->second->index(),
+                     it->second);
+      } else {
+        return invalid();
+      }
+    }
+    if (flags & kModule)
+      gate->module(true);
+    gate->coherent(flags & kGateCoherent);
+    gate->order(order);
+    gates.emplace(index, std::move(gate));
+  }
+  auto it_root = gates.find(header.root);
+  if (!std::feof(file.get()) || it_root == gates.end())
+    return invalid();
+  graph->root(it_root->second);
+  graph->register_null_gates_ = true;
+  LOG(DEBUG2) << "Loaded the preprocessed PDAG from the cache: " << path_;
+  return graph;
+}
+
+void PdagCache::Store(const Pdag& graph) noexcept {
+  std::vector<std::int32_t> orders(graph.basic_events().size());
+  std::vector<const Gate*> gates;  // In post-order.
+  std::unordered_set<int> visited;
+  auto collect = [&orders, &gates, &visited](auto& self,
+                                             const Gate& gate) -> void {
+    if (!visited.insert(gate.index()).second)
+      return;
+    for (const auto& arg : gate.args<Gate>())
+      self(self, arg.second);
+    for (const auto& arg : gate.args<Variable>())
+      orders[arg.second.index() - Pdag::kVariableStartIndex] =
+          arg.second.order();
+    gates.push_back(&gate);
+  };
+  collect(collect, graph.root());
+
+  boost::system::error_code error;
+  fs::path path(path_);
+  fs::create_directories(path.parent_path(), error);
+  fs::path temp_path = path;
+  temp_path += fs::unique_path(".%%%%-%%%%.tmp", error);
+  if (error) {
+    LOG(WARNING) << "Cannot prepare the PDAG cache file: " << path_ << "\n"
+                 << error.message();
+    return;
+  }
+  FilePtr file(std::fopen(temp_path.c_str(), "wb"));
+  if (!file) {
+    LOG(WARNING) << "Cannot write the PDAG cache file: " << temp_path;
+    return;
+  }
+
+  Header header = {};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.flags = (graph.complement() ? kComplement : 0) |
+                 (graph.coherent() ? kCoherent : 0) |
+                 (graph.normal() ? kNormal : 0);
+  header.key = key_;
+  header.key_size = key_material_.size();
+  header.num_variables = orders.size();
+  header.root = graph.root().index();
+  bool success = Write(header, file.get());
+  success &= std::fwrite(key_material_.data(), 1, key_material_.size(),
+                         file.get()) == key_material_.size();
+  for (std::int32_t order : orders)
+    success &= Write(order, file.get());
+
+  for (const Gate* gate : gates) {
+    success &= Write<std::int32_t>(gate->index(), file.get());
+    success &= Write<std::uint8_t>(gate->type(), file.get());
+    success &= Write<std::uint8_t>((gate->module() ? kModule : 0u) |
+                                       (gate->coherent() ? kGateCoherent : 0),
+                                   file.get());
+    success &= Write<std::int32_t>(gate->vote_number(), file.get());
+    success &= Write<std::int32_t>(gate->order(), file.get());
+    success &= Write<std::uint32_t>(gate->args().size(), file.get());
+    for (int arg : gate->args())
+      success &= Write<std::int32_t>(arg, file.get());
+  }
+  success &= std::fclose(file.release()) == 0;
+  if (success)
+    fs::rename(temp_path, path, error);
+  if (!success || error) {
+    LOG(WARNING) << "Failed to store the PDAG cache file: " << path_;
+    fs::remove(temp_path, error);
+    return;
+  }
+  LOG(DEBUG2) << "Stored the preprocessed PDAG in the cache: " << path_;
+}
+
+}  // namespace scram::core
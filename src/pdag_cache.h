@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2018 Olzhas Rakhimov
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// Persistent on-disk cache of preprocessed PDAGs.
+
+#pragma once
+
+#include <cstdint>
+
+#include <memory>
+#include <string>
+
+#include "pdag.h"
+#include "settings.h"
+
+namespace scram::core {
+
+/// Content-addressed storage of preprocessed PDAGs in a directory.
+/// The key is the hash of the PDAG right after its construction
+/// from the model (i.e., the relevant model slice with substitutions,
+/// CCF expansion, and house event states),
+/// the basic event identifiers,
+/// the settings that affect preprocessing,
+/// and the software version.
+///
+/// The cache is best-effort:
+/// failures to read or write cache files are logged and ignored,
+/// and the graph is preprocessed as usual.
+class PdagCache {
+ public:
+  /// Computes the cache key of the graph.
+  ///
+  /// @param[in] graph  The PDAG fresh from the construction.
+  /// @param[in] settings  The analysis settings with the cache directory.
+  ///
+  /// @pre The graph has not been preprocessed.
+  PdagCache(const Pdag& graph, const Settings& settings) noexcept;
+
+  /// Loads the preprocessed version of the graph from the cache.
+  ///
+  /// @returns The preprocessed PDAG ready for analysis.
+  /// @returns nullptr if the cache has no valid entry.
+  ///
+  /// @pre The original graph given upon construction is alive.
+  std::shared_ptr<Pdag> Load() noexcept;
+
+  /// Stores the preprocessed version of the graph into the cache.
+  ///
+  /// @param[in] graph  The preprocessed original graph.
+  void Store(const Pdag& graph) noexcept;
+
+ private:
+  const Pdag& graph_;  ///< The original graph.
+  std::string key_material_;  ///< The serialized original graph and settings.
+  std::uint64_t key_;  ///< The hash of the key material.
+  std::string path_;  ///< The cache file path for the graph.
+};
+
+}  // namespace scram::core
@@ -72,12 +72,15 @@
 
 #include "preprocessor.h"
 
+#include <cmath>
 #include <cstdlib>
 
 #include <algorithm>
 #include <array>
 #include <list>
+#include <numeric>
 #include <queue>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <boost/functional/hash.hpp>
@@ -85,6 +88,7 @@
 #include <boost/range/algorithm.hpp>
 #include <boost/range/algorithm_ext.hpp>
 
+#include "bdd.h"
 #include "ext/algorithm.h"
 #include "ext/find_iterator.h"
 #include "logger.h"
@@ -126,6 +130,237 @@ void TopologicalOrder(Pdag* graph) noexcept {
   topological_order(topological_order, graph->root().get(), 0);
 }
 
+namespace {
+
+/// Gathers all nodes of the graph.
+///
+/// @param[in,out] graph  The graph with the topological order.
+///
+/// @returns The nodes in the ascending order,
+///          i.e., arguments before their parents.
+///
+/// @post Node visit information is dirty.
+std::vector<Node*> GatherOrderedNodes(Pdag* graph) noexcept {
+  std::vector<Node*> nodes;
+  auto gather = [&nodes](auto& self, Gate* gate) -> void {
+    if (gate->Visited())
+      return;
+    gate->Visit(1);
+    nodes.push_back(gate);
+    for (const Gate::Arg<Gate>& arg : gate->args<Gate>())
+      self(self, arg.second.get());
+    for (const Gate::Arg<Variable>& arg : gate->args<Variable>()) {
+      if (!arg.second->Visited()) {
+        arg.second->Visit(1);
+        nodes.push_back(arg.second.get());
+      }
+    }
+  };
+  graph->Clear<Pdag::kVisit>();
+  gather(gather, graph->root().get());
+  boost::sort(nodes, [](const Node* lhs, const Node* rhs) {
+    return lhs->order() < rhs->order();
+  });
+  return nodes;
+}
+
+/// Reassigns the order of nodes
+/// by sorting the variables and sub-modules of each module.
+/// The nodes with lower keys get lower orders
+/// to be closer to the root of decision diagrams.
+/// The ties are broken with the current order.
+///
+/// The variables and sub-modules of a module are placed
+/// below the module,
+/// and the rest of the module gates are placed
+/// between the module and its variables in the topological order.
+///
+/// @param[in,out] graph  The graph with the topological order.
+/// @param[in] keys  The sort keys of the nodes mapped by their indices.
+///
+/// @post Gate orders are greater than the orders of their arguments.
+/// @post Node visit information is dirty.
+void AssignOrder(Pdag* graph,
+                 const std::unordered_map<int, double>& keys) noexcept {
+  // Gathers the variables and sub-modules of a module
+  // and the rest of the module gates in the post-order.
+  auto gather = [](auto& self, Gate* gate, std::vector<Node*>* members,
+                   std::vector<Gate*>* gates) -> void {
+    for (const Gate::Arg<Gate>& arg : gate->args<Gate>()) {
+      Gate* child = arg.second.get();
+      if (child->Visited())
+        continue;
+      child->Visit(1);
+      if (child->module()) {
+        members->push_back(child);
+      } else {
+        self(self, child, members, gates);
+        gates->push_back(child);
+      }
+    }
+    for (const Gate::Arg<Variable>& arg : gate->args<Variable>()) {
+      if (!arg.second->Visited()) {
+        arg.second->Visit(1);
+        members->push_back(arg.second.get());
+      }
+    }
+  };
+  auto assign_order = [&keys, &gather](auto& self, Gate* module,
+                                       int order) -> int {
+    std::vector<Node*> members;
+    std::vector<Gate*> gates;
+    gather(gather, module, &members, &gates);
+    boost::sort(members, [&keys](const Node* lhs, const Node* rhs) {
+      double lhs_key = keys.at(lhs->index());
+      double rhs_key = keys.at(rhs->index());
+      if (lhs_key != rhs_key)
+        return lhs_key < rhs_key;
+      return lhs->order() < rhs->order();
+    });
+    for (Node* member : members) {
+      if (auto* sub_module = dynamic_cast<Gate*>(member)) {
+        order = self(self, sub_module, order);
+      } else {
+        member->order(++order);
+      }
+    }
+    for (Gate* gate : gates)
+      gate->order(++order);
+    module->order(++order);
+    return order;
+  };
+  graph->Clear<Pdag::kVisit>();
+  graph->root()->Visit(1);
+  assign_order(assign_order, graph->root().get(), 0);
+}
+
+}  // namespace
+
+void ForceOrder(Pdag* graph) noexcept {
+  TopologicalOrder(graph);  // The initial placement.
+  std::vector<Node*> nodes = GatherOrderedNodes(graph);
+  std::unordered_map<int, int> positions;  // Node indices to positions.
+  for (int i = 0; i < nodes.size(); ++i)
+    positions.emplace(nodes[i]->index(), i);
+
+  // Every gate with its arguments is a hyperedge.
+  std::vector<std::vector<int>> edges;
+  std::vector<std::vector<int>> node_edges(nodes.size());
+  for (int i = 0; i < nodes.size(); ++i) {
+    auto* gate = dynamic_cast<Gate*>(nodes[i]);
+    if (!gate)
+      continue;
+    std::vector<int> edge = {i};
+    for (int arg : gate->args())
+      edge.push_back(positions.at(std::abs(arg)));
+    for (int node : edge)
+      node_edges[node].push_back(edges.size());
+    edges.push_back(std::move(edge));
+  }
+  std::vector<int> placement(nodes.size());  // Node positions.
+  std::iota(placement.begin(), placement.end(), 0);
+  auto total_span = [&edges](const std::vector<int>& place) {
+    std::int64_t span = 0;
+    for (const std::vector<int>& edge : edges) {
+      int min = place[edge.front()];
+      int max = min;
+      for (int node : edge) {
+        min = std::min(min, place[node]);
+        max = std::max(max, place[node]);
+      }
+      span += max - min;
+    }
+    return span;
+  };
+  std::vector<int> best_placement = placement;
+  std::int64_t best_span = total_span(placement);
+  int max_iterations = std::ceil(std::log2(nodes.size() + 1));
+  std::vector<double> gravity(edges.size());
+  std::vector<double> targets(nodes.size());
+  std::vector<int> ranking(nodes.size());
+  for (int iteration = 0; iteration < max_iterations; ++iteration) {
+    for (int i = 0; i < edges.size(); ++i) {
+      double sum = 0;
+      for (int node : edges[i])
+        sum += placement[node];
+      gravity[i] = sum / edges[i].size();
+    }
+    for (int i = 0; i < nodes.size(); ++i) {
+      double sum = 0;
+      for (int edge : node_edges[i])
+        sum += gravity[edge];
+      targets[i] = sum / node_edges[i].size();
+    }
+    std::iota(ranking.begin(), ranking.end(), 0);
+    boost::stable_sort(ranking, [&targets, &placement](int lhs, int rhs) {
+      if (targets[lhs] != targets[rhs])
+        return targets[lhs] < targets[rhs];
+      return placement[lhs] < placement[rhs];
+    });
+    for (int i = 0; i < ranking.size(); ++i)
+      placement[ranking[i]] = i;
+    std::int64_t span = total_span(placement);
+    if (span >= best_span)
+      break;
+    best_span = span;
+    best_placement = placement;
+  }
+  LOG(DEBUG5) << "FORCE span: " << best_span;
+
+  std::unordered_map<int, double> keys;
+  for (int i = 0; i < nodes.size(); ++i)
+    keys.emplace(nodes[i]->index(), best_placement[i]);
+  AssignOrder(graph, keys);
+}
+
+void FanInOrder(Pdag* graph) noexcept {
+  TopologicalOrder(graph);  // Parents are processed before arguments.
+  std::vector<Node*> nodes = GatherOrderedNodes(graph);
+  std::unordered_map<int, double> weights = {{graph->root()->index(), 1}};
+  for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+    auto* gate = dynamic_cast<Gate*>(*it);
+    if (!gate)
+      continue;
+    double share = weights[gate->index()] / gate->args().size();
+    for (int arg : gate->args())
+      weights[std::abs(arg)] += share;
+  }
+  std::unordered_map<int, double> keys;
+  for (Node* node : nodes)
+    keys.emplace(node->index(), -weights[node->index()]);  // Heavy first.
+  AssignOrder(graph, keys);
+}
+
+bool OrderFirst(Pdag* graph, const std::vector<int>& indices) noexcept {
+  std::unordered_set<int> top_variables;  // The variables of the root module.
+  auto gather = [&top_variables](auto& self, Gate* gate) -> void {
+    for (const Gate::Arg<Gate>& arg : gate->args<Gate>()) {
+      if (!arg.second->module() && !arg.second->Visited()) {
+        arg.second->Visit(1);
+        self(self, arg.second.get());
+      }
+    }
+    for (const Gate::Arg<Variable>& arg : gate->args<Variable>())
+      top_variables.insert(arg.second->index());
+  };
+  graph->Clear<Pdag::kVisit>();
+  gather(gather, graph->root().get());
+
+  std::unordered_map<int, double> keys;
+  for (Node* node : GatherOrderedNodes(graph))
+    keys.emplace(node->index(), 0);
+  for (int i = 0; i < indices.size(); ++i) {
+    auto it = keys.find(indices[i]);
+    if (it == keys.end())
+      continue;
+    if (!top_variables.count(indices[i]))
+      return false;
+    it->second = i - static_cast<int>(indices.size());
+  }
+  AssignOrder(graph, keys);
+  return true;
+}
+
 void MarkCoherence(Pdag* graph) noexcept {
   auto mark_coherence = [](auto& self, const GatePtr& gate) {
     if (gate->mark())
@@ -167,7 +402,8 @@ void MarkCoherence(Pdag* graph) noexcept {
 
 }  // namespace pdag
 
-Preprocessor::Preprocessor(Pdag* graph) noexcept : graph_(graph) {}
+Preprocessor::Preprocessor(Pdag* graph, const Settings& settings) noexcept
+    : graph_(graph), kSettings_(settings) {}
 
 void Preprocessor::operator()() noexcept {
   TIMER(DEBUG2, "Preprocessing");
@@ -596,36 +832,49 @@ void Preprocessor::NormalizeVoteGate(const GatePtr& gate) noexcept {
     return;
   }
 
-  auto it = boost::max_element(gate->args(), [&gate](int lhs, int rhs) {
-    return gate->GetArg(lhs)->order() < gate->GetArg(rhs)->order();
+  // The arguments with larger orders go first.
+  std::vector<int> args(gate->args().begin(), gate->args().end());
+  boost::stable_sort(args, [&gate](int lhs, int rhs) {
+    return gate->GetArg(lhs)->order() > gate->GetArg(rhs)->order();
   });
-  assert(it != gate->args().cend());
-  auto first_arg = std::make_shared<Gate>(kAnd, graph_);
-  gate->TransferArg(*it, first_arg);
-
-  auto grand_arg = std::make_shared<Gate>(kVote, graph_);
-  first_arg->AddArg(grand_arg);
-  grand_arg->vote_number(vote_number - 1);
-
-  auto second_arg = std::make_shared<Gate>(kVote, graph_);
-  second_arg->vote_number(vote_number);
-
-  for (int index : gate->args()) {
-    gate->ShareArg(index, grand_arg);
-    gate->ShareArg(index, second_arg);
-  }
-
-  first_arg->mark(true);
-  second_arg->mark(true);
-  grand_arg->mark(true);
+  int num_args = args.size();
+  // The K/N gates over the argument suffixes shared between the branches.
+  std::vector<std::vector<GatePtr>> vote_gates(
+      num_args, std::vector<GatePtr>(vote_number + 1));
+
+  // Returns the gate for K/N(args[start:]) with at least two arguments.
+  auto get_vote_gate = [this, &gate, &args, &vote_gates, num_args](
+                           auto& self, int start, int votes) -> GatePtr {
+    int num_rest = num_args - start;
+    assert(num_rest > 1 && votes > 0 && votes <= num_rest);
+    GatePtr& vote_gate = vote_gates[start][votes];
+    if (vote_gate)
+      return vote_gate;
+    if (votes == 1 || votes == num_rest) {
+      vote_gate = std::make_shared<Gate>(votes == 1 ? kOr : kAnd, graph_);
+      for (int i = start; i < num_args; ++i)
+        gate->ShareArg(args[i], vote_gate);
+    } else {  // 1 < votes < num_rest leaves at least two arguments to recurse.
+      vote_gate = std::make_shared<Gate>(kOr, graph_);
+      auto first_arg = std::make_shared<Gate>(kAnd, graph_);
+      first_arg->mark(true);
+      gate->ShareArg(args[start], first_arg);
+      first_arg->AddArg(self(self, start + 1, votes - 1));
+      vote_gate->AddArg(first_arg);
+      vote_gate->AddArg(self(self, start + 1, votes));
+    }
+    vote_gate->mark(true);
+    return vote_gate;
+  };
 
+  // The top gate of the recursion is substituted by the original gate.
+  GatePtr top = get_vote_gate(get_vote_gate, 0, vote_number);
+  assert(top->type() == kOr && top->args<Gate>().size() == 2);
   gate->type(kOr);
   gate->EraseArgs();
-  gate->AddArg(first_arg);
-  gate->AddArg(second_arg);
-
-  NormalizeVoteGate(grand_arg);
-  NormalizeVoteGate(second_arg);
+  std::vector<int> top_args(top->args().begin(), top->args().end());
+  for (int index : top_args)
+    top->TransferArg(index, gate);
 }
 
 void Preprocessor::PropagateComplements(
@@ -1441,14 +1690,24 @@ void Preprocessor::FindBaseOption(
     MergeTable::MergeGroup::iterator* best_option) noexcept {
   *best_option = all_options->end();
   std::array<int, 3> best_counts{};  // The number of extra parents.
+  // The number of parents of the arguments of representative gates
+  // to avoid the linear search for each common argument.
+  std::unordered_map<const Gate*, std::unordered_map<int, int>> arg_parents;
   for (auto it = all_options->begin(); it != all_options->end(); ++it) {
     int num_parents = it->second.size();
     const GatePtr& parent = *it->second.begin();  // Representative.
+    auto [it_parent, inserted] = arg_parents.try_emplace(parent.get());
+    if (inserted) {
+      std::unordered_map<int, int>& counts = it_parent->second;
+      for (const auto& arg : parent->args<Gate>())
+        counts.emplace(arg.first, arg.second->parents().size());
+      for (const auto& arg : parent->args<Variable>())
+        counts.emplace(arg.first, arg.second->parents().size());
+    }
     const MergeTable::CommonArgs& args = it->first;
     std::array<int, 3> cur_counts{};
     for (int index : args) {
-      NodePtr arg = parent->GetArg(index);
-      int extra_count = arg->parents().size() - num_parents;
+      int extra_count = it_parent->second.at(index) - num_parents;
       if (extra_count > 2)
         continue;  // Optimal decision criterion.
       ++cur_counts[extra_count];  // Logging extra parents.
@@ -1482,13 +1741,9 @@ void Preprocessor::TransformCommonArgs(MergeTable::MergeGroup* group) noexcept {
     const GatePtr& parent = *common_parents.begin();  // To get the arguments.
     assert(parent->args().size() > 1);
     auto merge_gate = std::make_shared<Gate>(parent->type(), graph_);
-    for (int index : common_args) {
-      parent->ShareArg(index, merge_gate);
-      for (const GatePtr& common_parent : common_parents) {
-        common_parent->EraseArg(index);
-      }
-    }
+    parent->ShareArgs(common_args, merge_gate);
     for (const GatePtr& common_parent : common_parents) {
+      common_parent->EraseArgs(common_args);
       common_parent->AddArg(merge_gate);
       if (common_parent->args().size() == 1) {
         common_parent->type(kNull);  // Assumes AND/OR gates only.
@@ -2343,6 +2598,50 @@ bool Preprocessor::RegisterToClear(const GatePtr& gate) noexcept {
   return gate->constant() || gate->type() == kNull;  // automatic register.
 }
 
+void Preprocessor::AssignOrder() noexcept {
+  switch (kSettings_.variable_order()) {
+    case VariableOrder::kDfs:
+      pdag::TopologicalOrder(graph_);
+      break;
+    case VariableOrder::kForce:
+      pdag::ForceOrder(graph_);
+      break;
+    case VariableOrder::kFanIn:
+      pdag::FanInOrder(graph_);
+      break;
+    case VariableOrder::kTournament:
+      RunOrderTournament();
+      break;
+  }
+}
+
+void Preprocessor::RunOrderTournament() noexcept {
+  TIMER(DEBUG3, "Variable ordering tournament");
+  const std::pair<VariableOrder, void (*)(Pdag*) noexcept> candidates[] = {
+      {VariableOrder::kDfs, &pdag::TopologicalOrder},
+      {VariableOrder::kForce, &pdag::ForceOrder},
+      {VariableOrder::kFanIn, &pdag::FanInOrder}};
+  Settings settings = Settings(kSettings_).reorder_time(0);
+  int winner = 0;
+  int best_size = 0;
+  for (int i = 0; i < std::size(candidates); ++i) {
+    candidates[i].second(graph_);
+    int size = Bdd(graph_, settings).CountIteNodes();
+    LOG(DEBUG4) << "BDD size with the '"
+                << kVariableOrderToString[static_cast<int>(candidates[i].first)]
+                << "' variable order: " << size;
+    if (!i || size < best_size) {
+      winner = i;
+      best_size = size;
+    }
+  }
+  LOG(DEBUG3) << "The winner variable order: "
+              << kVariableOrderToString[static_cast<int>(
+                     candidates[winner].first)];
+  if (winner != std::size(candidates) - 1)
+    candidates[winner].second(graph_);
+}
+
 void Preprocessor::GatherNodes(std::vector<GatePtr>* gates,
                                std::vector<VariablePtr>* variables) noexcept {
   graph_->Clear<Pdag::kVisit>();
@@ -2368,7 +2667,8 @@ void Preprocessor::GatherNodes(const GatePtr& gate, std::vector<GatePtr>* gates,
 
 void CustomPreprocessor<Bdd>::Run() noexcept {
   Preprocessor::Run();
-  pdag::Transform(graph_, &pdag::MarkCoherence, &pdag::TopologicalOrder);
+  pdag::Transform(graph_, &pdag::MarkCoherence,
+                  [this](Pdag*) { AssignOrder(); });
 }
 
 void CustomPreprocessor<Zbdd>::Run() noexcept {
@@ -2379,7 +2679,7 @@ void CustomPreprocessor<Zbdd>::Run() noexcept {
                       RunPhaseFour();
                   },
                   [this](Pdag*) { RunPhaseFive(); }, &pdag::MarkCoherence,
-                  &pdag::TopologicalOrder);
+                  [this](Pdag*) { AssignOrder(); });
 }
 
 void CustomPreprocessor<Mocus>::Run() noexcept {
@@ -31,6 +31,7 @@
 #include <boost/unordered_map.hpp>
 
 #include "pdag.h"
+#include "settings.h"
 
 namespace scram::core {
 
@@ -73,6 +74,43 @@ std::vector<T*> OrderArguments(Gate* gate) noexcept;
 /// @post The root and descendant node order marks contain the ordering.
 void TopologicalOrder(Pdag* graph) noexcept;
 
+/// Assigns ordering to nodes of the PDAG
+/// with the FORCE heuristic.
+/// Starting with the topological order,
+/// every node is repeatedly moved to the center of gravity
+/// of the gates it is connected to
+/// while the total span of the gates shrinks.
+///
+/// @param[in,out] graph  The graph to be processed.
+///
+/// @post The root and descendant node order marks contain the ordering.
+/// @post Gate orders are greater than the orders of their arguments.
+void ForceOrder(Pdag* graph) noexcept;
+
+/// Assigns ordering to nodes of the PDAG
+/// with the weighted fan-in heuristic.
+/// The unit weight of the root is split evenly among gate arguments
+/// down the graph,
+/// and the heavier nodes are placed closer to the root.
+///
+/// @param[in,out] graph  The graph to be processed.
+///
+/// @post The root and descendant node order marks contain the ordering.
+/// @post Gate orders are greater than the orders of their arguments.
+void FanInOrder(Pdag* graph) noexcept;
+
+/// Moves the given variables of the root module
+/// to the top of the assigned ordering.
+/// The relative order of the rest of the nodes is kept.
+///
+/// @param[in,out] graph  The graph with the assigned ordering.
+/// @param[in] indices  The indices of the variables in the desired order.
+///                     The variables missing in the graph are ignored.
+///
+/// @returns false if some of the variables belong to sub-modules;
+///          the ordering is left intact in that case.
+bool OrderFirst(Pdag* graph, const std::vector<int>& indices) noexcept;
+
 /// Marks coherence of the whole graph.
 ///
 /// @param[in,out] graph  The graph to be processed.
@@ -92,6 +130,7 @@ class Preprocessor : private boost::noncopyable {
   /// representing a fault tree.
   ///
   /// @param[in] graph  The PDAG to be preprocessed.
+  /// @param[in] settings  The analysis settings with the variable ordering.
   ///
   /// @warning There should not be another shared pointer to the root gate
   ///          outside of the passed PDAG.
@@ -101,7 +140,7 @@ class Preprocessor : private boost::noncopyable {
   ///          the destructor will not be called
   ///          as expected by the preprocessing algorithms,
   ///          which will mess the new structure of the PDAG.
-  explicit Preprocessor(Pdag* graph) noexcept;
+  Preprocessor(Pdag* graph, const Settings& settings) noexcept;
 
   virtual ~Preprocessor() = default;
 
@@ -240,6 +279,10 @@ class Preprocessor : private boost::noncopyable {
   /// than the alternative,
   /// which is OR of AND gates of combinations.
   /// Normalization of K/N gates is aware of variable ordering.
+  /// The sub-gates for the same (remaining arguments, votes) pair
+  /// are shared between the branches,
+  /// so the number of new gates is O(K * N)
+  /// instead of the combinatorial expansion.
   ///
   /// @param[in,out] gate  The VOTE gate to normalize.
   ///
@@ -474,8 +517,17 @@ class Preprocessor : private boost::noncopyable {
   /// how to merge or factor out
   /// common arguments of gates into new gates.
   struct MergeTable {
+    /// Orders gates by their indices
+    /// instead of addresses for reproducible transformations.
+    struct IndexLess {
+      /// @returns true if the lhs gate index is less than the rhs one.
+      bool operator()(const GatePtr& lhs, const GatePtr& rhs) const {
+        return lhs->index() < rhs->index();
+      }
+    };
     using CommonArgs = std::vector<int>;  ///< Unique, sorted common arguments.
-    using CommonParents = std::set<GatePtr>;  ///< Unique common parent gates.
+    /// Unique common parent gates.
+    using CommonParents = std::set<GatePtr, IndexLess>;
     using Option = std::pair<CommonArgs, CommonParents>;  ///< One possibility.
     using OptionGroup = std::vector<Option*>;  ///< A set of best options.
     using MergeGroup = std::vector<Option>;  ///< Isolated group for processing.
@@ -972,6 +1024,18 @@ class Preprocessor : private boost::noncopyable {
   /// @pre The caller will later call the appropriate cleanup functions.
   bool RegisterToClear(const GatePtr& gate) noexcept;
 
+  /// Assigns the variable ordering
+  /// with the heuristic requested in the settings.
+  ///
+  /// @post The root and descendant node order marks contain the ordering.
+  void AssignOrder() noexcept;
+
+  /// Assigns the ordering of the heuristic
+  /// that yields the smallest trial BDD of the graph.
+  ///
+  /// @note The trial BDDs are built without variable reordering.
+  void RunOrderTournament() noexcept;
+
   /// Gathers all nodes in the PDAG.
   ///
   /// @param[out] gates  A set of gates.
@@ -993,6 +1057,9 @@ class Preprocessor : private boost::noncopyable {
 
   /// @todo Eliminate the protected data.
   Pdag* graph_;  ///< The PDAG to preprocess.
+
+ private:
+  const Settings kSettings_;  ///< Analysis settings.
 };
 
 /// Undefined template class for specialization of Preprocessor
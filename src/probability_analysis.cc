@@ -21,9 +21,14 @@
 
 #include "probability_analysis.h"
 
+#include <cmath>
+
+#include <algorithm>
+
 #include <boost/range/algorithm/find_if.hpp>
 
 #include "event.h"
+#include "expression_program.h"
 #include "logger.h"
 #include "parameter.h"
 #include "settings.h"
@@ -53,6 +58,13 @@ void ProbabilityAnalysis::Analyze() noexcept {
   Analysis::AddAnalysisTime(DUR(p_time));
 }
 
+void ProbabilityAnalysis::Reanalyze() noexcept {
+  Analysis::ResetAnalysis();
+  this->UpdateVariableProbabilities();
+  sil_.reset();
+  Analyze();
+}
+
 ///< @todo Use Boost math integration instead.
 namespace {  // Integration primitives.
 
@@ -156,35 +168,240 @@ void ProbabilityAnalysis::ComputeSil() noexcept {
   }
 }
 
-double CutSetProbabilityCalculator::Calculate(
-    const std::vector<int>& cut_set,
-    const Pdag::IndexMap<double>& p_vars) noexcept {
-  double p_sub_set = 1;  // 1 is for multiplication.
-  for (int member : cut_set) {
-    assert(member > 0 && "Complements in a cut set.");
-    p_sub_set *= p_vars[member];
+FlatProducts::FlatProducts(const Zbdd& products) noexcept : offsets_(1) {
+  for (const std::vector<int>& product : products) {
+    for (int member : product) {
+      assert(member > 0 && "Complements in a product.");
+      members_.push_back(member);
+    }
+    offsets_.push_back(members_.size());
   }
-  return p_sub_set;
+}
+
+double FlatProducts::CalculatePartials(
+    int product, const Pdag::IndexMap<double>& p_vars,
+    std::vector<std::pair<int, double>>* partials) const noexcept {
+  partials->clear();
+  double prefix = 1;
+  for (int i = offsets_[product]; i < offsets_[product + 1]; ++i) {
+    partials->emplace_back(members_[i], prefix);
+    prefix *= p_vars[members_[i]];
+  }
+  double suffix = 1;
+  for (auto it = partials->rbegin(); it != partials->rend(); ++it) {
+    it->second *= suffix;
+    suffix *= p_vars[it->first];
+  }
+  return prefix;
 }
 
 double RareEventCalculator::Calculate(
-    const Zbdd& cut_sets, const Pdag::IndexMap<double>& p_vars) noexcept {
+    const FlatProducts& cut_sets,
+    const Pdag::IndexMap<double>& p_vars) const noexcept {
   double sum = 0;
-  for (const std::vector<int>& cut_set : cut_sets) {
-    sum += CutSetProbabilityCalculator::Calculate(cut_set, p_vars);
-  }
+  for (int i = 0; i < cut_sets.size(); ++i)
+    sum += cut_sets.Calculate(i, p_vars);
   return sum > 1 ? 1 : sum;
 }
 
+void RareEventCalculator::Calculate(const FlatProducts& cut_sets,
+                                    const double* p_vars, int num_lanes,
+                                    double* results) const noexcept {
+  std::fill_n(results, num_lanes, 0);
+  std::vector<double> p_product(num_lanes);
+  for (int i = 0; i < cut_sets.size(); ++i) {
+    cut_sets.Calculate(i, p_vars, num_lanes, p_product.data());
+    for (int j = 0; j < num_lanes; ++j)
+      results[j] += p_product[j];
+  }
+  for (int j = 0; j < num_lanes; ++j)
+    results[j] = std::min(results[j], 1.0);
+}
+
+void RareEventCalculator::CalculateMifs(
+    const FlatProducts& cut_sets, const Pdag::IndexMap<double>& p_vars,
+    Pdag::IndexMap<double>* mifs) const noexcept {
+  mifs->assign(p_vars.size(), 0);
+  std::vector<std::pair<int, double>> partials;
+  double sum = 0;
+  for (int i = 0; i < cut_sets.size(); ++i) {
+    sum += cut_sets.CalculatePartials(i, p_vars, &partials);
+    for (const auto& [index, partial] : partials)
+      (*mifs)[index] += partial;
+  }
+  for (int index = Pdag::kVariableStartIndex;
+       index < p_vars.size() + Pdag::kVariableStartIndex; ++index) {
+    double derivative = (*mifs)[index];
+    double p_true = sum + (1 - p_vars[index]) * derivative;
+    if (p_true > 1) {  // The conditional probabilities are adjusted to 1.
+      double p_false = sum - p_vars[index] * derivative;
+      (*mifs)[index] = 1 - std::min(p_false, 1.0);
+    }
+  }
+}
+
 double McubCalculator::Calculate(
-    const Zbdd& cut_sets, const Pdag::IndexMap<double>& p_vars) noexcept {
+    const FlatProducts& cut_sets,
+    const Pdag::IndexMap<double>& p_vars) const noexcept {
   double m = 1;
-  for (const std::vector<int>& cut_set : cut_sets) {
-    m *= 1 - CutSetProbabilityCalculator::Calculate(cut_set, p_vars);
-  }
+  for (int i = 0; i < cut_sets.size(); ++i)
+    m *= 1 - cut_sets.Calculate(i, p_vars);
   return 1 - m;
 }
 
+void McubCalculator::Calculate(const FlatProducts& cut_sets,
+                               const double* p_vars, int num_lanes,
+                               double* results) const noexcept {
+  std::fill_n(results, num_lanes, 1);
+  std::vector<double> p_product(num_lanes);
+  for (int i = 0; i < cut_sets.size(); ++i) {
+    cut_sets.Calculate(i, p_vars, num_lanes, p_product.data());
+    for (int j = 0; j < num_lanes; ++j)
+      results[j] *= 1 - p_product[j];
+  }
+  for (int j = 0; j < num_lanes; ++j)
+    results[j] = 1 - results[j];
+}
+
+void McubCalculator::CalculateMifs(
+    const FlatProducts& cut_sets, const Pdag::IndexMap<double>& p_vars,
+    Pdag::IndexMap<double>* mifs) const noexcept {
+  // The products with the probability of 1 are counted
+  // instead of the logarithms of their complements.
+  int num_certain = 0;
+  double log_complement = 0;
+  Pdag::IndexMap<int> var_certain(p_vars.size());
+  Pdag::IndexMap<double> var_log_complement(p_vars.size());
+  Pdag::IndexMap<double> var_log_conditional(p_vars.size());
+  std::vector<std::pair<int, double>> partials;
+  for (int i = 0; i < cut_sets.size(); ++i) {
+    double p_product = cut_sets.CalculatePartials(i, p_vars, &partials);
+    bool certain = p_product == 1;
+    double log_product = certain ? 0 : std::log1p(-p_product);
+    num_certain += certain;
+    log_complement += log_product;
+    for (const auto& [index, partial] : partials) {
+      var_certain[index] += certain;
+      var_log_complement[index] += log_product;
+      var_log_conditional[index] += std::log1p(-partial);
+    }
+  }
+  // MIF = (1 - M(p=1)) - (1 - M(p=0)) = M(p=0) * (1 - M(p=1) / M(p=0)).
+  mifs->resize(p_vars.size());
+  for (int index = Pdag::kVariableStartIndex;
+       index < p_vars.size() + Pdag::kVariableStartIndex; ++index) {
+    if (num_certain > var_certain[index]) {
+      (*mifs)[index] = 0;  // The other products are certain.
+    } else {
+      double m_false = std::exp(log_complement - var_log_complement[index]);
+      (*mifs)[index] = -m_false * std::expm1(var_log_conditional[index]);
+    }
+  }
+}
+
+FlatBdd::FlatBdd(const Bdd& bdd) noexcept
+    : vertices_(1), complement_(bdd.root().complement) {
+  std::unordered_map<int, int> positions;
+  Flatten(bdd.root().vertex, bdd, &positions);
+}
+
+int FlatBdd::Flatten(const Bdd::VertexPtr& vertex, const Bdd& bdd,
+                     std::unordered_map<int, int>* positions) noexcept {
+  if (vertex->terminal())
+    return 0;
+  if (auto it = positions->find(vertex->id()); it != positions->end())
+    return it->second;
+  const Ite& ite = Ite::Ref(vertex);
+  Vertex flat{ite.index() - Pdag::kVariableStartIndex,
+              0,
+              0,
+              ite.order(),
+              ite.module(),
+              false,
+              ite.complement_edge()};
+  if (ite.module()) {
+    const Bdd::Function& res = bdd.modules().find(ite.index())->second;
+    flat.index = Flatten(res.vertex, bdd, positions);
+    flat.complement_module = res.complement;
+  }
+  flat.high = Flatten(ite.high(), bdd, positions);
+  flat.low = Flatten(ite.low(), bdd, positions);
+  vertices_.push_back(flat);
+  int position = vertices_.size() - 1;
+  positions->emplace(vertex->id(), position);
+  return position;
+}
+
+void FlatBdd::Calculate(const double* p_vars, int num_lanes,
+                        std::vector<double>* values,
+                        double* results) const noexcept {
+  values->resize(vertices_.size() * num_lanes);
+  double* p = values->data();
+  std::fill_n(p, num_lanes, 1);  // The terminal vertex.
+  for (int i = 1; i < vertices_.size(); ++i) {
+    const Vertex& vertex = vertices_[i];
+    double* p_vertex = p + i * num_lanes;
+    const double* p_high = p + vertex.high * num_lanes;
+    const double* p_low = p + vertex.low * num_lanes;
+    const double* p_var = vertex.module ? p + vertex.index * num_lanes
+                                        : p_vars + vertex.index * num_lanes;
+    // The branches are hoisted out of the loops over the lanes.
+    if (vertex.module && vertex.complement_module) {
+      if (vertex.complement_edge) {
+        for (int j = 0; j < num_lanes; ++j)
+          p_vertex[j] = (1 - p_var[j]) * p_high[j] + p_var[j] * (1 - p_low[j]);
+      } else {
+        for (int j = 0; j < num_lanes; ++j)
+          p_vertex[j] = (1 - p_var[j]) * p_high[j] + p_var[j] * p_low[j];
+      }
+    } else if (vertex.complement_edge) {
+      for (int j = 0; j < num_lanes; ++j)
+        p_vertex[j] = p_var[j] * p_high[j] + (1 - p_var[j]) * (1 - p_low[j]);
+    } else {
+      for (int j = 0; j < num_lanes; ++j)
+        p_vertex[j] = p_var[j] * p_high[j] + (1 - p_var[j]) * p_low[j];
+    }
+  }
+  const double* p_root = p + (vertices_.size() - 1) * num_lanes;
+  for (int j = 0; j < num_lanes; ++j)
+    results[j] = complement_ ? 1 - p_root[j] : p_root[j];
+}
+
+void FlatBdd::CalculateMifs(const double* p_vars,
+                            const std::vector<double>& values,
+                            std::vector<double>* adjoints,
+                            std::vector<double>* mifs) const noexcept {
+  assert(values.size() == vertices_.size() && "Missing probabilities.");
+  std::fill(mifs->begin(), mifs->end(), 0);
+  adjoints->assign(vertices_.size(), 0);
+  double* d = adjoints->data();
+  const double* p = values.data();
+  d[vertices_.size() - 1] = 1;  // The root.
+  for (int i = vertices_.size() - 1; i > 0; --i) {
+    if (!d[i])
+      continue;  // The vertex doesn't contribute to the root.
+    const Vertex& vertex = vertices_[i];
+    double p_var = 0;
+    if (vertex.module) {
+      p_var = p[vertex.index];
+      if (vertex.complement_module)
+        p_var = 1 - p_var;
+    } else {
+      p_var = p_vars[vertex.index];
+    }
+    double low = vertex.complement_edge ? 1 - p[vertex.low] : p[vertex.low];
+    double derivative = d[i] * (p[vertex.high] - low);
+    if (!vertex.module) {
+      (*mifs)[vertex.index] += derivative;
+    } else {
+      d[vertex.index] += vertex.complement_module ? -derivative : derivative;
+    }
+    d[vertex.high] += d[i] * p_var;
+    d[vertex.low] += vertex.complement_edge ? -d[i] * (1 - p_var)
+                                            : d[i] * (1 - p_var);
+  }
+}
+
 void ProbabilityAnalyzerBase::ExtractVariableProbabilities() {
   p_vars_.reserve(graph_->basic_events().size());
   for (const mef::BasicEvent* event : graph_->basic_events())
@@ -201,18 +418,46 @@ ProbabilityAnalyzerBase::CalculateProbabilityOverTime() noexcept {
   assert(Analysis::settings().mission_time() ==
          ProbabilityAnalysis::mission_time().value());
   double total_time = ProbabilityAnalysis::mission_time().value();
-
-  auto update = [this, &p_time](double time) {
-    mission_time().value(time);
-    auto it_p = p_vars_.begin();
-    for (const mef::BasicEvent* event : graph_->basic_events())
-      *it_p++ = event->p();
-    p_time.emplace_back(this->CalculateTotalProbability(p_vars_), time);
-  };
-
   for (double time = 0; time < total_time; time += time_step)
-    update(time);
-  update(total_time);  // Handle cases when total_time is not divisible by step.
+    p_time.emplace_back(0, time);
+  p_time.emplace_back(0, total_time);  // Handle the non-divisible total time.
+
+  // Only the time-dependent variables are re-evaluated at every time step
+  // with the expressions compiled into a single program.
+  mef::ExpressionProgram program(&mission_time());
+  std::vector<int> dynamic_vars;
+  for (int i = 0; i < p_vars_.size(); ++i) {
+    mef::Expression& expression =
+        graph_->basic_events().data()[i]->expression();
+    if (program.IsDynamic(&expression)) {
+      dynamic_vars.push_back(i);
+      program.AddOutput(&expression);
+    }
+  }
+
+  // The time points are calculated in batches (lanes)
+  // to bound the memory for the intermediate values.
+  const int kNumLanes = 8;
+  std::vector<double> batch;
+  std::vector<double> dynamic_values(dynamic_vars.size() * kNumLanes);
+  double times[kNumLanes];
+  double results[kNumLanes];
+  for (int first = 0; first < p_time.size(); first += kNumLanes) {
+    int num_lanes = std::min<int>(kNumLanes, p_time.size() - first);
+    for (int j = 0; j < num_lanes; ++j)
+      times[j] = p_time[first + j].second;
+    program.Evaluate(times, num_lanes, dynamic_values.data());
+    batch.resize(p_vars_.size() * num_lanes);
+    for (int i = 0; i < p_vars_.size(); ++i)
+      std::fill_n(&batch[i * num_lanes], num_lanes, p_vars_.data()[i]);
+    for (int k = 0; k < dynamic_vars.size(); ++k) {
+      std::copy_n(&dynamic_values[k * num_lanes], num_lanes,
+                  &batch[dynamic_vars[k] * num_lanes]);
+    }
+    this->CalculateTotalProbabilities(batch.data(), num_lanes, results);
+    for (int j = 0; j < num_lanes; ++j)
+      p_time[first + j].first = results[j];
+  }
   return p_time;
 }
 
@@ -221,8 +466,7 @@ ProbabilityAnalyzer<Bdd>::ProbabilityAnalyzer(FaultTreeAnalyzer<Bdd>* fta,
     : ProbabilityAnalyzerBase(fta, mission_time), owner_(false) {
   LOG(DEBUG2) << "Re-using BDD from FaultTreeAnalyzer for ProbabilityAnalyzer";
   bdd_graph_ = fta->algorithm();
-  const Bdd::VertexPtr& root = bdd_graph_->root().vertex;
-  current_mark_ = root->terminal() ? false : Ite::Ref(root).mark();
+  flat_bdd_ = std::make_unique<FlatBdd>(*bdd_graph_);
 }
 
 ProbabilityAnalyzer<Bdd>::~ProbabilityAnalyzer() noexcept {
@@ -234,11 +478,8 @@ double ProbabilityAnalyzer<Bdd>::CalculateTotalProbability(
     const Pdag::IndexMap<double>& p_vars) noexcept {
   CLOCK(calc_time);  // BDD based calculation time.
   LOG(DEBUG4) << "Calculating probability with BDD...";
-  current_mark_ = !current_mark_;
-  double prob =
-      CalculateProbability(bdd_graph_->root().vertex, current_mark_, p_vars);
-  if (bdd_graph_->root().complement)
-    prob = 1 - prob;
+  double prob = 0;
+  flat_bdd_->Calculate(p_vars.data(), 1, &values_, &prob);
   LOG(DEBUG4) << "Calculated probability " << prob << " in " << DUR(calc_time);
   return prob;
 }
@@ -253,41 +494,16 @@ void ProbabilityAnalyzer<Bdd>::CreateBdd(
 
   CLOCK(prep_time);  // Overall preprocessing time.
   LOG(DEBUG2) << "Preprocessing...";
-  CustomPreprocessor<Bdd>{&graph}();
+  CustomPreprocessor<Bdd>{&graph, Analysis::settings()}();
   LOG(DEBUG2) << "Finished preprocessing in " << DUR(prep_time);
 
   CLOCK(bdd_time);  // BDD based calculation time.
   LOG(DEBUG2) << "Creating BDD for Probability Analysis...";
   bdd_graph_ = new Bdd(&graph, Analysis::settings());
+  flat_bdd_ = std::make_unique<FlatBdd>(*bdd_graph_);
   LOG(DEBUG2) << "BDD is created in " << DUR(bdd_time);
 
   Analysis::AddAnalysisTime(DUR(total_time));
 }
 
-double ProbabilityAnalyzer<Bdd>::CalculateProbability(
-    const Bdd::VertexPtr& vertex, bool mark,
-    const Pdag::IndexMap<double>& p_vars) noexcept {
-  if (vertex->terminal())
-    return 1;
-  Ite& ite = Ite::Ref(vertex);
-  if (ite.mark() == mark)
-    return ite.p();
-  ite.mark(mark);
-  double p_var = 0;
-  if (ite.module()) {
-    const Bdd::Function& res = bdd_graph_->modules().find(ite.index())->second;
-    p_var = CalculateProbability(res.vertex, mark, p_vars);
-    if (res.complement)
-      p_var = 1 - p_var;
-  } else {
-    p_var = p_vars[ite.index()];
-  }
-  double high = CalculateProbability(ite.high(), mark, p_vars);
-  double low = CalculateProbability(ite.low(), mark, p_vars);
-  if (ite.complement_edge())
-    low = 1 - low;
-  ite.p(p_var * high + (1 - p_var) * low);
-  return ite.p();
-}
-
 }  // namespace scram::core
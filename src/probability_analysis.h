@@ -20,6 +20,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -76,6 +79,15 @@ class ProbabilityAnalysis : public Analysis {
   /// @post The mission time expression has its original value.
   void Analyze() noexcept;
 
+  /// Re-runs the finished analysis
+  /// with the current values of the model expressions,
+  /// e.g., after changes in parameters or basic event probabilities.
+  /// The products and decision diagrams of the analysis are reused as is.
+  ///
+  /// @pre The analysis is done.
+  /// @pre The fault tree structure has not changed.
+  void Reanalyze() noexcept;
+
   /// @returns The total probability calculated by the analysis.
   ///
   /// @pre The analysis is done.
@@ -113,6 +125,10 @@ class ProbabilityAnalysis : public Analysis {
   virtual std::vector<std::pair<double, double>>
   CalculateProbabilityOverTime() noexcept = 0;
 
+  /// Updates the probabilities of the variables
+  /// with the current values of the model expressions.
+  virtual void UpdateVariableProbabilities() noexcept = 0;
+
   /// Computes probability metrics related to the SIL.
   void ComputeSil() noexcept;
 
@@ -122,31 +138,90 @@ class ProbabilityAnalysis : public Analysis {
   std::unique_ptr<Sil> sil_;  ///< The Safety Integrity Level results.
 };
 
-/// Quantitative calculator of a probability value of a single cut set.
-class CutSetProbabilityCalculator {
+class Zbdd;  // The container of analysis products for computations.
+
+/// Products compiled into a contiguous array of variable indices
+/// (compressed rows of products)
+/// for repeated calculations of probabilities.
+/// Unlike the iteration over the ZBDD,
+/// the calculations with the compiled products
+/// don't rebuild the products on every call
+/// and are reentrant.
+class FlatProducts {
  public:
-  /// Calculates a probability of a cut set,
+  /// Compiles the products for calculations.
+  ///
+  /// @param[in] products  The fully constructed products.
+  ///
+  /// @pre The products don't contain complements.
+  explicit FlatProducts(const Zbdd& products) noexcept;
+
+  /// @returns The number of products.
+  int size() const { return offsets_.size() - 1; }
+
+  /// Calculates a probability of a product,
   /// whose members are in AND relationship with each other.
   /// This function assumes independence of each member.
   ///
-  /// @param[in] cut_set  A cut set with positive indices of basic events.
+  /// @param[in] product  The position of the product.
   /// @param[in] p_vars  Probabilities of events mapped by the variable indices.
   ///
-  /// @returns The total probability of the cut set.
-  /// @returns 1 for an empty cut set indicating the base set.
+  /// @returns The total probability of the product.
+  /// @returns 1 for an empty product indicating the base set.
   ///
-  /// @pre The cut set doesn't contain complements.
   /// @pre Probability values are non-negative.
-  /// @pre Indices of events directly map to vector indices.
-  double Calculate(const std::vector<int>& cut_set,
-                   const Pdag::IndexMap<double>& p_vars) noexcept;
-};
+  double Calculate(int product,
+                   const Pdag::IndexMap<double>& p_vars) const noexcept {
+    double p_product = 1;  // 1 is for multiplication.
+    for (int i = offsets_[product]; i < offsets_[product + 1]; ++i)
+      p_product *= p_vars[members_[i]];
+    return p_product;
+  }
 
-class Zbdd;  // The container of analysis products for computations.
+  /// Calculates the probabilities of a product
+  /// for a batch of variable probability vectors (lanes) at once.
+  ///
+  /// @param[in] product  The position of the product.
+  /// @param[in] p_vars  Probabilities of variables in the variable-major order,
+  ///                    i.e., (index - kVariableStartIndex) * num_lanes + lane.
+  /// @param[in] num_lanes  The number of probability vectors in the batch.
+  /// @param[out] results  The probability of the product for each lane.
+  void Calculate(int product, const double* p_vars, int num_lanes,
+                 double* results) const noexcept {
+    std::fill_n(results, num_lanes, 1);
+    for (int i = offsets_[product]; i < offsets_[product + 1]; ++i) {
+      const double* p_var =
+          p_vars + (members_[i] - Pdag::kVariableStartIndex) * num_lanes;
+      for (int j = 0; j < num_lanes; ++j)
+        results[j] *= p_var[j];
+    }
+  }
+
+  /// Calculates the partial derivatives of the probability of a product
+  /// with respect to the probabilities of its members,
+  /// i.e., the probabilities of the products without the members.
+  /// The derivatives are combined from the prefix and suffix partial products
+  /// instead of the division by the member probabilities,
+  /// which can be 0.
+  ///
+  /// @param[in] product  The position of the product.
+  /// @param[in] p_vars  Probabilities of events mapped by the variable indices.
+  /// @param[out] partials  The variable indices of the product members
+  ///                       with their partial derivatives.
+  ///
+  /// @returns The total probability of the product.
+  double CalculatePartials(
+      int product, const Pdag::IndexMap<double>& p_vars,
+      std::vector<std::pair<int, double>>* partials) const noexcept;
+
+ private:
+  std::vector<int> offsets_;  ///< The start positions of the products.
+  std::vector<int> members_;  ///< The variable indices of all the products.
+};
 
 /// Quantitative calculator of probability values
 /// with the Rare-Event approximation.
-class RareEventCalculator : private CutSetProbabilityCalculator {
+class RareEventCalculator {
  public:
   /// Calculates probabilities
   /// using the Rare-Event approximation.
@@ -160,13 +235,37 @@ class RareEventCalculator : private CutSetProbabilityCalculator {
   ///       the probability is adjusted to 1.
   ///       It is very unwise to use the rare-event approximation
   ///       with large probability values.
-  double Calculate(const Zbdd& cut_sets,
-                   const Pdag::IndexMap<double>& p_vars) noexcept;
+  double Calculate(const FlatProducts& cut_sets,
+                   const Pdag::IndexMap<double>& p_vars) const noexcept;
+
+  /// Calculates probabilities with the Rare-Event approximation
+  /// for a batch of variable probability vectors (lanes) at once.
+  ///
+  /// @param[in] cut_sets  A collection of sets of indices of basic events.
+  /// @param[in] p_vars  Probabilities of variables in the variable-major order.
+  /// @param[in] num_lanes  The number of probability vectors in the batch.
+  /// @param[out] results  The total probability for each lane.
+  void Calculate(const FlatProducts& cut_sets, const double* p_vars,
+                 int num_lanes, double* results) const noexcept;
+
+  /// Calculates the Marginal Importance Factors of all variables
+  /// in a single sweep over the products.
+  /// The approximation is linear in every variable probability
+  /// up to the adjustment of the total probability to 1;
+  /// thus, the factors are the sums of the products without the variables.
+  ///
+  /// @param[in] cut_sets  A collection of sets of indices of basic events.
+  /// @param[in] p_vars  Probabilities of events mapped by the variable indices.
+  /// @param[out] mifs  The differences of the total probabilities
+  ///                   conditional on the variable states (1 and 0).
+  void CalculateMifs(const FlatProducts& cut_sets,
+                     const Pdag::IndexMap<double>& p_vars,
+                     Pdag::IndexMap<double>* mifs) const noexcept;
 };
 
 /// Quantitative calculator of probability values
 /// with the Min-Cut-Upper Bound approximation.
-class McubCalculator : private CutSetProbabilityCalculator {
+class McubCalculator {
  public:
   /// Calculates probabilities
   /// using the minimal cut set upper bound (MCUB) approximation.
@@ -175,8 +274,111 @@ class McubCalculator : private CutSetProbabilityCalculator {
   /// @param[in] p_vars  Probabilities of events mapped by the variable indices.
   ///
   /// @returns The total probability with the MCUB approximation.
-  double Calculate(const Zbdd& cut_sets,
-                   const Pdag::IndexMap<double>& p_vars) noexcept;
+  double Calculate(const FlatProducts& cut_sets,
+                   const Pdag::IndexMap<double>& p_vars) const noexcept;
+
+  /// Calculates probabilities with the MCUB approximation
+  /// for a batch of variable probability vectors (lanes) at once.
+  ///
+  /// @param[in] cut_sets  A collection of sets of indices of basic events.
+  /// @param[in] p_vars  Probabilities of variables in the variable-major order.
+  /// @param[in] num_lanes  The number of probability vectors in the batch.
+  /// @param[out] results  The total probability for each lane.
+  void Calculate(const FlatProducts& cut_sets, const double* p_vars,
+                 int num_lanes, double* results) const noexcept;
+
+  /// Calculates the Marginal Importance Factors of all variables
+  /// in a single sweep over the products.
+  /// The complement of the upper bound is the product of
+  /// the complements of the product probabilities;
+  /// the factors are combined from the sums of their logarithms
+  /// with and without the products of every variable.
+  ///
+  /// @param[in] cut_sets  A collection of sets of indices of basic events.
+  /// @param[in] p_vars  Probabilities of events mapped by the variable indices.
+  /// @param[out] mifs  The differences of the total probabilities
+  ///                   conditional on the variable states (1 and 0).
+  void CalculateMifs(const FlatProducts& cut_sets,
+                     const Pdag::IndexMap<double>& p_vars,
+                     Pdag::IndexMap<double>* mifs) const noexcept;
+};
+
+/// Flat copy of a BDD function graph in topological order
+/// for reentrant and batched calculations of probabilities.
+/// The vertices are stored contiguously and reference each other
+/// by 32-bit positions,
+/// and the calculation results are kept in side arrays
+/// indexed by the vertex positions
+/// instead of the shared BDD vertices;
+/// thus, the calculations can run concurrently with private side arrays.
+class FlatBdd {
+ public:
+  /// Copies the function graph of the BDD with its modules.
+  ///
+  /// @param[in] bdd  The fully constructed BDD.
+  explicit FlatBdd(const Bdd& bdd) noexcept;
+
+  /// Calculates the exact probabilities of the BDD function
+  /// for a batch of variable probability vectors (lanes) at once.
+  /// The calculations are uniform across the lanes for every vertex,
+  /// so the inner loops over the lanes are vectorized by the compiler.
+  ///
+  /// @param[in] p_vars  Probabilities of variables in the variable-major order,
+  ///                    i.e., (index - kVariableStartIndex) * num_lanes + lane.
+  /// @param[in] num_lanes  The number of probability vectors in the batch.
+  /// @param[in,out] values  Storage for intermediate probabilities.
+  /// @param[out] results  The total probability for each lane.
+  void Calculate(const double* p_vars, int num_lanes,
+                 std::vector<double>* values, double* results) const noexcept;
+
+  /// Calculates the Marginal Importance Factors of all variables at once.
+  /// The partial derivatives of the BDD function
+  /// are accumulated in a single backward sweep over the vertices
+  /// (parents before arguments),
+  /// including the variables inside modules
+  /// through the derivatives of the module functions.
+  ///
+  /// @param[in] p_vars  Probabilities of variables in the variable order,
+  ///                    i.e., (index - kVariableStartIndex).
+  /// @param[in] values  The probabilities of the vertices
+  ///                    calculated for the same variable probabilities
+  ///                    with a single lane.
+  /// @param[in,out] adjoints  Storage for the derivatives of the vertices.
+  /// @param[out] mifs  The importance factors of the variables
+  ///                   for the uncomplemented BDD function
+  ///                   in the variable order.
+  ///                   The variables not in the BDD get 0.
+  ///
+  /// @pre The size of mifs is the number of variables.
+  void CalculateMifs(const double* p_vars, const std::vector<double>& values,
+                     std::vector<double>* adjoints,
+                     std::vector<double>* mifs) const noexcept;
+
+ private:
+  /// Vertex copy with arguments referenced by positions.
+  struct Vertex {
+    int index;  ///< The variable position or the position of the module root.
+    int high;  ///< The position of the high vertex.
+    int low;  ///< The position of the low vertex.
+    int order;  ///< The order of the variable or module.
+    bool module;  ///< The index refers to a module.
+    bool complement_module;  ///< The module function is complemented.
+    bool complement_edge;  ///< The low edge is complemented.
+  };
+
+  /// Copies vertices into the flat storage in post-order.
+  ///
+  /// @param[in] vertex  The vertex to copy with its descendants.
+  /// @param[in] bdd  The owner of the vertex.
+  /// @param[in,out] positions  The positions of already copied vertices.
+  ///
+  /// @returns The position of the vertex in the flat storage.
+  int Flatten(const Bdd::VertexPtr& vertex, const Bdd& bdd,
+              std::unordered_map<int, int>* positions) noexcept;
+
+  /// Args before parents with the terminal vertex at position 0.
+  std::vector<Vertex> vertices_;
+  bool complement_;  ///< The complement of the BDD function.
 };
 
 /// Base class for Probability analyzers.
@@ -225,6 +427,21 @@ class ProbabilityAnalyzerBase : public ProbabilityAnalysis {
     return this->CalculateTotalProbability(p_vars_);
   }
 
+  /// Calculates the total probabilities
+  /// for a batch of variable probability vectors (lanes) at once.
+  ///
+  /// @param[in] p_vars  Probabilities of variables in the variable-major order,
+  ///                    i.e., (index - kVariableStartIndex) * num_lanes + lane.
+  /// @param[in] num_lanes  The number of probability vectors in the batch.
+  /// @param[out] results  The total probability for each lane.
+  virtual void CalculateTotalProbabilities(const double* p_vars, int num_lanes,
+                                           double* results) noexcept = 0;
+
+  void UpdateVariableProbabilities() noexcept final {
+    p_vars_.clear();
+    ExtractVariableProbabilities();
+  }
+
   std::vector<std::pair<double, double>>
   CalculateProbabilityOverTime() noexcept final;
 
@@ -250,15 +467,40 @@ class ProbabilityAnalyzerBase : public ProbabilityAnalysis {
 template <class Calculator>
 class ProbabilityAnalyzer : public ProbabilityAnalyzerBase {
  public:
-  using ProbabilityAnalyzerBase::ProbabilityAnalyzerBase;
+  /// Compiles the products of the fault tree analyzer
+  /// for all the calculations of the analyzer.
+  ///
+  /// @tparam Algorithm  Qualitative analysis algorithm.
+  ///
+  /// @copydetails ProbabilityAnalysis::ProbabilityAnalysis
+  template <class Algorithm>
+  ProbabilityAnalyzer(const FaultTreeAnalyzer<Algorithm>* fta,
+                      mef::MissionTime* mission_time)
+      : ProbabilityAnalyzerBase(fta, mission_time),
+        flat_products_(ProbabilityAnalyzerBase::products()) {}
 
   double CalculateTotalProbability(
       const Pdag::IndexMap<double>& p_vars) noexcept final {
-    return calc_.Calculate(ProbabilityAnalyzerBase::products(), p_vars);
+    return calc_.Calculate(flat_products_, p_vars);
+  }
+
+  /// Calculates the Marginal Importance Factors of all variables
+  /// with the current variable probabilities.
+  ///
+  /// @param[out] mifs  The factors mapped by the variable indices.
+  void CalculateMifs(Pdag::IndexMap<double>* mifs) noexcept {
+    calc_.CalculateMifs(flat_products_, ProbabilityAnalyzerBase::p_vars(),
+                        mifs);
   }
 
  private:
+  void CalculateTotalProbabilities(const double* p_vars, int num_lanes,
+                                   double* results) noexcept final {
+    calc_.Calculate(flat_products_, p_vars, num_lanes, results);
+  }
+
   Calculator calc_;  ///< Provider of the calculation logic.
+  FlatProducts flat_products_;  ///< The compiled products for calculations.
 };
 
 /// Specialization of probability analyzer with Binary Decision Diagrams.
@@ -275,9 +517,7 @@ class ProbabilityAnalyzer<Bdd> : public ProbabilityAnalyzerBase {
   template <class Algorithm>
   ProbabilityAnalyzer(const FaultTreeAnalyzer<Algorithm>* fta,
                       mef::MissionTime* mission_time)
-      : ProbabilityAnalyzerBase(fta, mission_time),
-        current_mark_(false),
-        owner_(true) {
+      : ProbabilityAnalyzerBase(fta, mission_time), owner_(true) {
     CreateBdd(*fta);
   }
 
@@ -299,10 +539,18 @@ class ProbabilityAnalyzer<Bdd> : public ProbabilityAnalyzerBase {
   /// @returns Binary decision diagram used for calculations.
   Bdd* bdd_graph() { return bdd_graph_; }
 
+  /// @returns The flat copy of the BDD for calculations.
+  const FlatBdd& flat_bdd() const { return *flat_bdd_; }
+
   double CalculateTotalProbability(
       const Pdag::IndexMap<double>& p_vars) noexcept final;
 
  private:
+  void CalculateTotalProbabilities(const double* p_vars, int num_lanes,
+                                   double* results) noexcept final {
+    flat_bdd_->Calculate(p_vars, num_lanes, &values_, results);
+  }
+
   /// Creates a new BDD for use by the analyzer.
   ///
   /// @param[in] fta  The fault tree analysis providing the root gate.
@@ -310,24 +558,10 @@ class ProbabilityAnalyzer<Bdd> : public ProbabilityAnalyzerBase {
   /// @pre The function is called in the constructor only once.
   void CreateBdd(const FaultTreeAnalysis& fta) noexcept;
 
-  /// Calculates exact probability
-  /// of a function graph represented by its root BDD vertex.
-  ///
-  /// @param[in] vertex  The root vertex of a function graph.
-  /// @param[in] mark  A flag to mark traversed vertices.
-  /// @param[in] p_vars  The probabilities of the variables
-  ///                    mapped by their indices.
-  ///
-  /// @returns Probability value.
-  ///
-  /// @warning If a vertex is already marked with the input mark,
-  ///          it will not be traversed and updated with a probability value.
-  double CalculateProbability(const Bdd::VertexPtr& vertex, bool mark,
-                              const Pdag::IndexMap<double>& p_vars) noexcept;
-
   Bdd* bdd_graph_;  ///< The main BDD graph for analysis.
-  bool current_mark_;  ///< To keep track of BDD current mark.
   bool owner_;  ///< Indication that pointers are handles.
+  std::unique_ptr<FlatBdd> flat_bdd_;  ///< The BDD copy for calculations.
+  std::vector<double> values_;  ///< The probabilities of the vertices.
 };
 
 }  // namespace scram::core
@@ -22,6 +22,7 @@
 
 #include <ctime>
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -139,9 +140,10 @@ void Reporter::ReportCalculatedQuantity<core::FaultTreeAnalysis>(
       case core::Algorithm::kMocus:
         methods.SetAttribute("name", "MOCUS");
     }
-    methods.AddChild("limits")
-        .AddChild("product-order")
-        .AddText(settings.limit_order());
+    xml::StreamElement limits = methods.AddChild("limits");
+    limits.AddChild("product-order").AddText(settings.limit_order());
+    if (settings.cut_off())
+      limits.AddChild("cut-off").AddText(settings.cut_off());
   }
   if (settings.ccf_analysis()) {
     information->AddChild("calculated-quantity")
@@ -394,6 +396,12 @@ void Reporter::ReportResults(const core::RiskAnalysis::Result::Id& id,
   if (prob_analysis)
     sum_of_products.SetAttribute("probability", prob_analysis->p_total());
 
+  if (fta.settings().cut_off()) {
+    sum_of_products.SetAttribute(
+        "truncated-probability",
+        std::min(1.0, fta.products().truncated_probability()));
+  }
+
   if (fta.products().empty() == false) {
     sum_of_products.SetAttribute(
         "distribution",
@@ -403,6 +411,8 @@ void Reporter::ReportResults(const core::RiskAnalysis::Result::Id& id,
                     " "));
   }
 
+  // The products are generated from the ZBDD on the fly
+  // and streamed out one at a time without intermediate copies.
   double sum = 0;  // Sum of probabilities for contribution calculations.
   if (prob_analysis) {
     for (const core::Product& product_set : fta.products())
@@ -20,8 +20,12 @@
 
 #include "risk_analysis.h"
 
+#include <unordered_map>
+#include <unordered_set>
+
 #include "bdd.h"
 #include "expression/random_deviate.h"
+#include "ext/parallel.h"
 #include "ext/scope_guard.h"
 #include "fault_tree.h"
 #include "logger.h"
@@ -80,6 +84,17 @@ void RiskAnalysis::RunAnalysis(std::optional<Context> context) noexcept {
     }
   }
 
+  /// The analysis target with its result slot and optional sequence.
+  struct Target {
+    const mef::Gate& gate;  ///< The root of the analysis.
+    int result_index;  ///< The position of the result in results_.
+    EventTreeAnalysis::Result* sequence;  ///< nullptr for fault tree tops.
+    std::shared_ptr<Pdag> graph;  ///< The PDAG shared by sequences if any.
+    std::unique_ptr<Bdd> bdd;  ///< The sequence function in the shared PDAG.
+  };
+  std::vector<Target> targets;
+  // The result slots are reserved upfront in the deterministic order;
+  // then, the targets are analyzed independently.
   for (const mef::InitiatingEventPtr& initiating_event :
        model_->initiating_events()) {
     if (initiating_event->event_tree()) {
@@ -87,21 +102,22 @@ void RiskAnalysis::RunAnalysis(std::optional<Context> context) noexcept {
       auto eta = std::make_unique<EventTreeAnalysis>(
           *initiating_event, Analysis::settings(), model_->context());
       eta->Analyze();
+      std::pair<std::shared_ptr<Pdag>, std::vector<std::unique_ptr<Bdd>>>
+          shared;
+      if (Analysis::settings().shared_sequences())
+        shared = ShareSequences(eta.get());
+      auto it_bdd = shared.second.begin();
       for (EventTreeAnalysis::Result& result : eta->sequences()) {
-        const mef::Sequence& sequence = result.sequence;
-        LOG(INFO) << "Running analysis for sequence: " << sequence.name();
+        targets.push_back({*result.gate, static_cast<int>(results_.size()),
+                           &result});
+        if (shared.first && !result.is_expression_only) {
+          targets.back().graph = shared.first;
+          targets.back().bdd = std::move(*it_bdd++);
+        }
         results_.push_back(
             {{std::pair<const mef::InitiatingEvent&, const mef::Sequence&>{
-                  *initiating_event, sequence},
+                  *initiating_event, result.sequence},
               context}});
-        RunAnalysis(*result.gate, &results_.back());
-        if (result.is_expression_only) {
-          results_.back().fault_tree_analysis = nullptr;
-          results_.back().importance_analysis = nullptr;
-        }
-        if (Analysis::settings().probability_analysis())
-          result.p_sequence = results_.back().probability_analysis->p_total();
-        LOG(INFO) << "Finished analysis for sequence: " << sequence.name();
       }
       event_tree_results_.push_back(
           {*initiating_event, context, std::move(eta)});
@@ -111,32 +127,129 @@ void RiskAnalysis::RunAnalysis(std::optional<Context> context) noexcept {
 
   for (const mef::FaultTreePtr& ft : model_->fault_trees()) {
     for (const mef::Gate* target : ft->top_events()) {
-      LOG(INFO) << "Running analysis for gate: " << target->id();
+      targets.push_back({*target, static_cast<int>(results_.size()), nullptr});
       results_.push_back({{target, context}});
-      RunAnalysis(*target, &results_.back());
-      LOG(INFO) << "Finished analysis for gate: " << target->id();
     }
   }
+
+  auto log_target = [](const Target& target, const char* status) {
+    if (target.sequence) {
+      LOG(INFO) << status << " analysis for sequence: "
+                << target.sequence->sequence.name();
+    } else {
+      LOG(INFO) << status << " analysis for gate: " << target.gate.id();
+    }
+  };
+  // The time-dependent analysis manipulates the model mission time.
+  int num_jobs =
+      Analysis::settings().time_step() ? 1 : Analysis::settings().jobs();
+  Settings target_settings = Analysis::settings();
+  if (num_jobs > 1 && targets.size() > 1)
+    target_settings.jobs(1);  // The targets are the unit of work per thread.
+  ext::parallel_for(num_jobs, targets.size(), [&](int i) {
+    log_target(targets[i], "Running");
+    Result* result = &results_[targets[i].result_index];
+    if (targets[i].bdd) {
+      auto fta = std::make_unique<FaultTreeAnalyzer<Bdd>>(
+          targets[i].gate, target_settings, model_);
+      fta->Analyze(std::move(targets[i].graph), std::move(targets[i].bdd));
+      RunAnalysis(std::move(fta), result);
+    } else {
+      RunAnalysis(targets[i].gate, target_settings, result);
+    }
+    log_target(targets[i], "Finished");
+  });
+
+  for (const Target& target : targets) {
+    Result& result = results_[target.result_index];
+    if (Analysis::settings().uncertainty_analysis())
+      RunUncertaintyAnalysis(&result);
+    if (!target.sequence)
+      continue;
+    sequences_.emplace_back(target.result_index, target.sequence);
+    if (target.sequence->is_expression_only) {
+      hidden_analyses_.push_back(std::move(result.fault_tree_analysis));
+      result.importance_analysis = nullptr;
+    }
+    if (Analysis::settings().probability_analysis())
+      target.sequence->p_sequence = result.probability_analysis->p_total();
+  }
+}
+
+void RiskAnalysis::Requantify() noexcept {
+  assert(!results_.empty() && "The analysis is not done.");
+  assert(!Analysis::settings().cut_off() && "Truncated products are stale.");
+  if (!Analysis::settings().probability_analysis())
+    return;
+  CLOCK(requantify_time);
+  LOG(INFO) << "Requantifying the analysis results...";
+  if (Analysis::settings().seed() >= 0)
+    mef::RandomDeviate::seed(Analysis::settings().seed());
+
+  mef::MissionTime& mission_time = model_->mission_time();
+  double init_time = mission_time.value();
+  ext::scope_guard restorator(
+      [&mission_time, init_time] { mission_time.value(init_time); });
+  // The phases and time steps manipulate the model mission time.
+  int num_jobs =
+      Analysis::settings().time_step() || !model_->alignments().empty()
+          ? 1
+          : Analysis::settings().jobs();
+  ext::parallel_for(num_jobs, results_.size(), [&](int i) {
+    Result& result = results_[i];
+    if (result.id.context) {
+      mission_time.value(result.id.context->phase.time_fraction() *
+                         init_time);
+    }
+    if (result.fault_tree_analysis) {
+      const_cast<FaultTreeAnalysis*>(result.fault_tree_analysis.get())
+          ->Requantify();
+    }
+    const_cast<ProbabilityAnalysis*>(result.probability_analysis.get())
+        ->Reanalyze();
+    if (result.importance_analysis)
+      RunImportanceAnalysis(&result);
+  });
+
+  for (const std::pair<int, EventTreeAnalysis::Result*>& sequence :
+       sequences_) {
+    sequence.second->p_sequence =
+        results_[sequence.first].probability_analysis->p_total();
+  }
+  if (Analysis::settings().uncertainty_analysis()) {
+    for (Result& result : results_)
+      RunUncertaintyAnalysis(&result);
+  }
+  LOG(INFO) << "Finished requantification in " << DUR(requantify_time);
 }
 
 void RiskAnalysis::RunAnalysis(const mef::Gate& target,
+                               const Settings& settings,
                                Result* result) noexcept {
   switch (Analysis::settings().algorithm()) {
     case Algorithm::kBdd:
-      return RunAnalysis<Bdd>(target, result);
+      return RunAnalysis<Bdd>(target, settings, result);
     case Algorithm::kZbdd:
-      return RunAnalysis<Zbdd>(target, result);
+      return RunAnalysis<Zbdd>(target, settings, result);
     case Algorithm::kMocus:
-      return RunAnalysis<Mocus>(target, result);
+      return RunAnalysis<Mocus>(target, settings, result);
   }
 }
 
 template <class Algorithm>
 void RiskAnalysis::RunAnalysis(const mef::Gate& target,
+                               const Settings& settings,
                                Result* result) noexcept {
-  auto fta = std::make_unique<FaultTreeAnalyzer<Algorithm>>(
-      target, Analysis::settings(), model_);
+  auto fta =
+      std::make_unique<FaultTreeAnalyzer<Algorithm>>(target, settings, model_);
   fta->Analyze();
+  RunAnalysis(std::move(fta), result);
+}
+
+template <class Algorithm>
+void RiskAnalysis::RunAnalysis(
+    std::unique_ptr<FaultTreeAnalyzer<Algorithm>> fta,
+    Result* result) noexcept {
   if (Analysis::settings().probability_analysis()) {
     switch (Analysis::settings().approximation()) {
       case Approximation::kNone:
@@ -158,17 +271,109 @@ void RiskAnalysis::RunAnalysis(FaultTreeAnalyzer<Algorithm>* fta,
   auto pa = std::make_unique<ProbabilityAnalyzer<Calculator>>(
       fta, &model_->mission_time());
   pa->Analyze();
-  if (Analysis::settings().importance_analysis()) {
-    auto ia = std::make_unique<ImportanceAnalyzer<Calculator>>(pa.get());
-    ia->Analyze();
-    result->importance_analysis = std::move(ia);
+  result->probability_analysis = std::move(pa);
+  if (Analysis::settings().importance_analysis())
+    RunImportanceAnalysis<Calculator>(result);
+}
+
+std::pair<std::shared_ptr<Pdag>, std::vector<std::unique_ptr<Bdd>>>
+RiskAnalysis::ShareSequences(EventTreeAnalysis* eta) noexcept {
+  std::vector<const EventTreeAnalysis::Result*> sequences;
+  for (const EventTreeAnalysis::Result& result : eta->sequences()) {
+    if (!result.is_expression_only)
+      sequences.push_back(&result);
   }
-  if (Analysis::settings().uncertainty_analysis()) {
-    auto ua = std::make_unique<UncertaintyAnalyzer<Calculator>>(pa.get());
-    ua->Analyze();
-    result->uncertainty_analysis = std::move(ua);
+  if (sequences.size() < 2)
+    return {};
+  CLOCK(share_time);
+  auto [gate, selectors] = eta->JoinSequences(sequences);
+  auto graph = std::make_shared<Pdag>(
+      *gate, Analysis::settings().ccf_analysis(), model_);
+  CustomPreprocessor<Bdd>{graph.get(), Analysis::settings()}();
+
+  std::unordered_map<const mef::BasicEvent*, int> event_indices;
+  int end_index = Pdag::kVariableStartIndex + graph->basic_events().size();
+  for (int i = Pdag::kVariableStartIndex; i < end_index; ++i)
+    event_indices.emplace(graph->basic_events()[i], i);
+  std::vector<int> indices;
+  for (const mef::BasicEvent* selector : selectors)
+    indices.push_back(event_indices.at(selector));
+  // The selectors must be on top of the root function.
+  if (graph->IsTrivial() || !pdag::OrderFirst(graph.get(), indices)) {
+    LOG(DEBUG2) << "The sequences cannot share the analysis.";
+    return {};
   }
-  result->probability_analysis = std::move(pa);
+  // Reordering would sink the selectors into the shared function.
+  Settings settings = Analysis::settings();
+  Bdd bdd(graph.get(), settings.reorder_time(0));
+  std::unordered_set<int> selector_indices(indices.begin(), indices.end());
+  std::vector<std::unique_ptr<Bdd>> bdds;
+  for (int index : indices) {
+    Bdd::Function function = bdd.root();
+    while (!function.vertex->terminal()) {
+      const Ite& ite = Ite::Ref(function.vertex);
+      if (!selector_indices.count(ite.index()))
+        break;
+      bool complement = function.complement;
+      if (ite.index() == index) {
+        function = {complement, ite.high()};
+      } else {
+        complement ^= ite.complement_edge();
+        function = {complement, ite.low()};
+      }
+    }
+    bdds.push_back(
+        std::make_unique<Bdd>(bdd, function, Analysis::settings()));
+  }
+  LOG(DEBUG2) << "Shared the BDD of " << indices.size() << " sequences in "
+              << DUR(share_time);
+  return {std::move(graph), std::move(bdds)};
+}
+
+void RiskAnalysis::RunImportanceAnalysis(Result* result) noexcept {
+  switch (Analysis::settings().approximation()) {
+    case Approximation::kNone:
+      return RunImportanceAnalysis<Bdd>(result);
+    case Approximation::kRareEvent:
+      return RunImportanceAnalysis<RareEventCalculator>(result);
+    case Approximation::kMcub:
+      return RunImportanceAnalysis<McubCalculator>(result);
+  }
+}
+
+template <class Calculator>
+void RiskAnalysis::RunImportanceAnalysis(Result* result) noexcept {
+  assert(result->probability_analysis && "Missing probability analysis.");
+  // The probability analyzer is created by this analysis with the calculator.
+  auto* pa = static_cast<ProbabilityAnalyzer<Calculator>*>(
+      const_cast<ProbabilityAnalysis*>(result->probability_analysis.get()));
+  auto ia = std::make_unique<ImportanceAnalyzer<Calculator>>(pa);
+  ia->Analyze();
+  result->importance_analysis = std::move(ia);
+}
+
+void RiskAnalysis::RunUncertaintyAnalysis(Result* result) noexcept {
+  switch (Analysis::settings().approximation()) {
+    case Approximation::kNone:
+      return RunUncertaintyAnalysis<Bdd>(result);
+    case Approximation::kRareEvent:
+      return RunUncertaintyAnalysis<RareEventCalculator>(result);
+    case Approximation::kMcub:
+      return RunUncertaintyAnalysis<McubCalculator>(result);
+  }
+}
+
+template <class Calculator>
+void RiskAnalysis::RunUncertaintyAnalysis(Result* result) noexcept {
+  assert(result->probability_analysis && "Missing probability analysis.");
+  // The probability analyzer is created by this analysis with the calculator.
+  auto* pa = static_cast<ProbabilityAnalyzer<Calculator>*>(
+      const_cast<ProbabilityAnalysis*>(result->probability_analysis.get()));
+  // The position of the result identifies the target in the reruns.
+  auto ua = std::make_unique<UncertaintyAnalyzer<Calculator>>(
+      pa, Analysis::settings().jobs(), result - results_.data());
+  ua->Analyze();
+  result->uncertainty_analysis = std::move(ua);
 }
 
 }  // namespace scram::core
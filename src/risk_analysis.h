@@ -102,6 +102,19 @@ class RiskAnalysis : public Analysis {
   /// @pre The analysis is performed only once.
   void Analyze() noexcept;
 
+  /// Re-runs the quantitative analyses (probability, SIL, importance,
+  /// uncertainty) with the current values of the model expressions,
+  /// e.g., after changes in parameters or basic event probabilities.
+  /// The PDAGs, products, and decision diagrams of the finished analysis
+  /// are reused without rebuilding.
+  ///
+  /// @pre The analysis is done.
+  /// @pre The structure of the model has not changed since the analysis,
+  ///      and the changed expressions are valid for the model.
+  /// @pre No cut-off probability is used
+  ///      since the products are truncated with the original probabilities.
+  void Requantify() noexcept;
+
   /// @returns The results of the analysis.
   const std::vector<Result>& results() const { return results_; }
 
@@ -120,12 +133,18 @@ class RiskAnalysis : public Analysis {
   /// @post The model is restored to the original state.
   void RunAnalysis(std::optional<Context> context = {}) noexcept;
 
-  /// Runs all possible analysis on a given target.
+  /// Runs all possible analysis on a given target
+  /// except for the uncertainty analysis.
   /// Analysis types are deduced from the settings.
   ///
   /// @param[in] target  Analysis target.
+  /// @param[in] settings  The analysis settings adjusted for the target.
   /// @param[in,out] result  The result container element.
-  void RunAnalysis(const mef::Gate& target, Result* result) noexcept;
+  ///
+  /// @note This function can run concurrently for different targets
+  ///       as long as the model is not manipulated in the meantime.
+  void RunAnalysis(const mef::Gate& target, const Settings& settings,
+                   Result* result) noexcept;
 
   /// Defines and runs Qualitative analysis on the target.
   /// Calls the Quantitative analysis if requested in settings.
@@ -133,9 +152,22 @@ class RiskAnalysis : public Analysis {
   /// @tparam Algorithm  Qualitative analysis algorithm.
   ///
   /// @param[in] target  Analysis target.
+  /// @param[in] settings  The analysis settings adjusted for the target.
+  /// @param[in,out] result  The result container element.
+  template <class Algorithm>
+  void RunAnalysis(const mef::Gate& target, const Settings& settings,
+                   Result* result) noexcept;
+
+  /// Runs the Quantitative analyses requested in settings
+  /// on the finished Qualitative analysis.
+  ///
+  /// @tparam Algorithm  Qualitative analysis algorithm.
+  ///
+  /// @param[in] fta  The finished Qualitative analysis of the target.
   /// @param[in,out] result  The result container element.
   template <class Algorithm>
-  void RunAnalysis(const mef::Gate& target, Result* result) noexcept;
+  void RunAnalysis(std::unique_ptr<FaultTreeAnalyzer<Algorithm>> fta,
+                   Result* result) noexcept;
 
   /// Defines and runs Quantitative analysis on the target.
   ///
@@ -150,9 +182,61 @@ class RiskAnalysis : public Analysis {
   template <class Algorithm, class Calculator>
   void RunAnalysis(FaultTreeAnalyzer<Algorithm>* fta, Result* result) noexcept;
 
+  /// Prepares the analysis of the event-tree sequences
+  /// with one PDAG and BDD shared by the sequences
+  /// instead of the full fault tree analysis per sequence.
+  /// The BDD function of each sequence is the restriction of the joint BDD
+  /// with the selector variables of the sequences on top of the ordering.
+  ///
+  /// @param[in,out] eta  The finished analysis of the event tree.
+  ///
+  /// @returns The shared PDAG and the BDDs of the sequences with formulas
+  ///          (i.e., not expression-only) in the order of the sequences,
+  ///          or the null graph if the sequences cannot share the analysis.
+  std::pair<std::shared_ptr<Pdag>, std::vector<std::unique_ptr<Bdd>>>
+  ShareSequences(EventTreeAnalysis* eta) noexcept;
+
+  /// Runs the uncertainty analysis on the finished probability analysis.
+  /// Unlike other analyses,
+  /// sampling manipulates the shared state of model expressions;
+  /// thus, targets must be sampled one at a time.
+  /// The random number streams of the targets
+  /// are distinguished by the result positions.
+  ///
+  /// @param[in,out] result  The result container element.
+  ///
+  /// @pre The result contains the probability analysis.
+  void RunUncertaintyAnalysis(Result* result) noexcept;
+
+  /// @tparam Calculator  Quantitative analysis algorithm
+  ///                     of the probability analysis in the result.
+  ///
+  /// @copydoc RunUncertaintyAnalysis(Result*)
+  template <class Calculator>
+  void RunUncertaintyAnalysis(Result* result) noexcept;
+
+  /// Runs the importance analysis on the finished probability analysis.
+  ///
+  /// @param[in,out] result  The result container element.
+  ///
+  /// @pre The result contains the probability analysis.
+  void RunImportanceAnalysis(Result* result) noexcept;
+
+  /// @tparam Calculator  Quantitative analysis algorithm
+  ///                     of the probability analysis in the result.
+  ///
+  /// @copydoc RunImportanceAnalysis(Result*)
+  template <class Calculator>
+  void RunImportanceAnalysis(Result* result) noexcept;
+
   mef::Model* model_;  ///< The model with constructs.
   std::vector<Result> results_;  ///< The analysis result storage.
   std::vector<EtaResult> event_tree_results_;  ///< Grouping of sequences.
+  /// The sequences with the positions of their results in results_.
+  std::vector<std::pair<int, EventTreeAnalysis::Result*>> sequences_;
+  /// The hidden analyses of expression-only sequences
+  /// kept alive for the requantification of the probability analyses.
+  std::vector<std::unique_ptr<const FaultTreeAnalysis>> hidden_analyses_;
 };
 
 }  // namespace scram::core
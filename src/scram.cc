@@ -29,17 +29,23 @@
 
 #include <boost/core/typeinfo.hpp>
 #include <boost/exception/all.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
 
+#include <libxml/globals.h>  // xmlThrDefSetGenericErrorFunc
 #include <libxml/parser.h>  // xmlInitParser, xmlCleanupParser
 #include <libxml/xmlerror.h>  // initGenericErrorDefaultFunc
 #include <libxml/xmlversion.h>  // LIBXML_TEST_VERSION
 
+#include "binary_report.h"
 #include "config.h"
 #include "error.h"
+#include "event.h"
+#include "expression/constant.h"
 #include "ext/scope_guard.h"
 #include "initializer.h"
 #include "logger.h"
+#include "parameter.h"
 #include "reporter.h"
 #include "risk_analysis.h"
 #include "serialization.h"
@@ -64,11 +70,14 @@ po::options_description ConstructOptions() {
       ("version", "Display version information")
       ("config-file", OPT_VALUE(path), "XML file with analysis configurations")
       ("allow-extern", "**UNSAFE** Allow external libraries")
+      ("trusted-input", "Skip the schema validation of valid input files")
       ("validate", "Validate input files without analysis")
       ("bdd", "Perform qualitative analysis with BDD")
       ("zbdd", "Perform qualitative analysis with ZBDD")
       ("mocus", "Perform qualitative analysis with MOCUS")
       ("prime-implicants", "Calculate prime implicants")
+      ("shared-sequences",
+       "Analyze event-tree sequences with a shared BDD")
       ("probability", OPT_VALUE(bool), "Perform probability analysis")
       ("importance", OPT_VALUE(bool), "Perform importance analysis")
       ("uncertainty", OPT_VALUE(bool), "Perform uncertainty analysis")
@@ -78,6 +87,8 @@ po::options_description ConstructOptions() {
       ("mcub", "Use the MCUB approximation")
       ("limit-order,l", OPT_VALUE(int), "Upper limit for the product order")
       ("cut-off", OPT_VALUE(double), "Cut-off probability for products")
+      ("top-products", OPT_VALUE(int),
+       "Number of the most probable products to report")
       ("mission-time", OPT_VALUE(double), "System mission time in hours")
       ("time-step", OPT_VALUE(double),
        "Time step in hours for probability analysis")
@@ -87,7 +98,19 @@ po::options_description ConstructOptions() {
        "Number of quantiles for distributions")
       ("num-bins", OPT_VALUE(int), "Number of bins for histograms")
       ("seed", OPT_VALUE(int), "Seed for the pseudo-random number generator")
+      ("jobs,j", OPT_VALUE(int), "Number of threads for independent analyses")
+      ("reorder-time", OPT_VALUE(double),
+       "Time limit in seconds for BDD variable reordering")
+      ("variable-order", OPT_VALUE(std::string),
+       "Variable ordering heuristic (dfs, force, fan-in, tournament)")
+      ("cache-dir", OPT_VALUE(path),
+       "Directory to cache preprocessed PDAGs across runs")
       ("output-path,o", OPT_VALUE(path), "Output path for reports")
+      ("binary-output", OPT_VALUE(path),
+       "Output path for the binary report of products")
+      ("what-if",
+       po::value<std::vector<std::string>>()->value_name("id=value,..."),
+       "Re-quantify and report with changed probabilities or parameters")
       ("no-indent", "Omit indentation whitespace in output XML")
       ("verbosity", OPT_VALUE(int), "Set log verbosity");
 #ifndef NDEBUG
@@ -209,6 +232,7 @@ void ConstructSettings(const po::variables_map& vm,
     settings->algorithm("mocus");
   }
   settings->prime_implicants(vm.count("prime-implicants"));
+  settings->shared_sequences(vm.count("shared-sequences"));
   // Determine if the probability approximation is requested.
   if (vm.count("rare-event")) {
     assert(!vm.count("mcub"));
@@ -226,10 +250,15 @@ void ConstructSettings(const po::variables_map& vm,
   SET("seed", int, seed);
   SET("limit-order", int, limit_order);
   SET("cut-off", double, cut_off);
+  SET("top-products", int, top_products);
   SET("mission-time", double, mission_time);
   SET("num-trials", int, num_trials);
   SET("num-quantiles", int, num_quantiles);
   SET("num-bins", int, num_bins);
+  SET("jobs", int, jobs);
+  SET("reorder-time", double, reorder_time);
+  SET("variable-order", std::string, variable_order);
+  SET("cache-dir", std::string, cache_dir);
 #ifndef NDEBUG
   settings->preprocessor = vm.count("preprocessor");
   settings->print = vm.count("print");
@@ -237,6 +266,96 @@ void ConstructSettings(const po::variables_map& vm,
 }
 #undef SET
 
+/// What-if changes of basic event probabilities and parameter values
+/// applied to the model for the lifetime of the scenario.
+class Scenario {
+ public:
+  /// Applies the changes to the model.
+  ///
+  /// @param[in] changes  Comma-separated "id=value" changes.
+  /// @param[in,out] model  The analysis model.
+  ///
+  /// @throws SettingsError  The changes are malformed or refer to unknown ids.
+  /// @throws DomainError  The changed probabilities are invalid.
+  Scenario(const std::string& changes, scram::mef::Model* model) {
+    try {
+      std::string::size_type pos = 0;
+      do {
+        std::string::size_type end = changes.find(',', pos);
+        Apply(changes.substr(pos, end - pos), model);
+        pos = end == std::string::npos ? end : end + 1;
+      } while (pos != std::string::npos);
+      for (const scram::mef::BasicEventPtr& event : model->basic_events()) {
+        if (event->HasExpression())
+          event->Validate();
+      }
+    } catch (...) {
+      Restore();
+      throw;
+    }
+  }
+
+  /// Restores the original expressions of the model.
+  ~Scenario() { Restore(); }
+
+ private:
+  /// Applies a single "id=value" change.
+  void Apply(const std::string& change, scram::mef::Model* model) {
+    std::string::size_type eq = change.find('=');
+    std::string id = change.substr(0, eq);
+    std::size_t num_chars = 0;
+    double value = 0;
+    try {
+      if (eq != std::string::npos)
+        value = std::stod(change.substr(eq + 1), &num_chars);
+    } catch (const std::exception&) {
+      num_chars = 0;
+    }
+    if (!num_chars || eq + 1 + num_chars != change.size()) {
+      SCRAM_THROW(scram::SettingsError("Invalid what-if change: '" + change +
+                                       "'. Expected id=value."));
+    }
+    auto* constant = values_
+                         .emplace_back(std::make_unique<
+                                       scram::mef::ConstantExpression>(value))
+                         .get();
+    if (auto it = model->basic_events().find(id);
+        it != model->basic_events().end()) {
+      scram::mef::BasicEvent* event = it->get();
+      expressions_.emplace_back(
+          event, event->HasExpression() ? &event->expression() : nullptr);
+      event->expression(constant);
+    } else if (auto it_param = model->parameters().find(id);
+               it_param != model->parameters().end()) {
+      parameters_.emplace_back(it_param->get(),
+                               (*it_param)->ReplaceExpression(constant));
+    } else {
+      SCRAM_THROW(scram::SettingsError(
+          "The what-if change refers to an undefined basic event or "
+          "parameter: " + id));
+    }
+  }
+
+  /// Restores the expressions in the reverse order of changes.
+  void Restore() noexcept {
+    for (auto it = expressions_.rbegin(); it != expressions_.rend(); ++it)
+      it->first->expression(it->second);
+    for (auto it = parameters_.rbegin(); it != parameters_.rend(); ++it)
+      it->first->ReplaceExpression(it->second);
+    expressions_.clear();
+    parameters_.clear();
+  }
+
+  /// The changed values.
+  std::vector<std::unique_ptr<scram::mef::ConstantExpression>> values_;
+  /// The changed basic events with their original expressions.
+  std::vector<std::pair<scram::mef::BasicEvent*, scram::mef::Expression*>>
+      expressions_;
+  /// The changed parameters with their original expressions.
+  std::vector<std::pair<scram::mef::Parameter*, scram::mef::Expression*>>
+      parameters_;
+};
+
 /// Main body of command-line entrance to run the program.
 ///
 /// @param[in] vm  Variables map of program options.
@@ -267,11 +386,19 @@ void RunScram(const po::variables_map& vm) {
   if (vm.count("output-path")) {
     output_path = vm["output-path"].as<std::string>();
   }
+  // The products truncated by the cut-off are only valid
+  // for the original probabilities of the model.
+  if (vm.count("what-if") && settings.cut_off()) {
+    SCRAM_THROW(scram::SettingsError(
+        "The what-if scenarios cannot be requantified "
+        "with the cut-off probability."));
+  }
   // Process input files
   // into valid analysis containers and constructs.
   // Throws if anything is invalid.
   std::shared_ptr<scram::mef::Model> model =
-      scram::mef::Initializer(input_files, settings, vm.count("allow-extern"))
+      scram::mef::Initializer(input_files, settings, vm.count("allow-extern"),
+                              vm.count("trusted-input"))
           .model();
 #ifndef NDEBUG
   if (vm.count("serialize"))
@@ -294,6 +421,27 @@ void RunScram(const po::variables_map& vm) {
   } else {
     reporter.Report(analysis, output_path, indent);
   }
+  if (vm.count("binary-output")) {
+    scram::BinaryReporter().Report(analysis,
+                                   vm["binary-output"].as<std::string>());
+  }
+  if (!vm.count("what-if"))
+    return;
+  // The what-if scenarios reuse the analysis structures
+  // and only re-quantify the results with the changed values.
+  auto scenarios = vm["what-if"].as<std::vector<std::string>>();
+  for (int i = 0; i < scenarios.size(); ++i) {
+    Scenario scenario(scenarios[i], model.get());
+    analysis.Requantify();
+    if (output_path.empty()) {
+      reporter.Report(analysis, stdout, indent);
+    } else {
+      boost::filesystem::path path(output_path);
+      path.replace_extension(".what-if-" + std::to_string(i + 1) +
+                             path.extension().string());
+      reporter.Report(analysis, path.string(), indent);
+    }
+  }
 }
 
 /// Callback function to redirect XML library error/warning messages to logging.
@@ -338,6 +486,8 @@ int main(int argc, char* argv[]) {
 
   xmlGenericErrorFunc xml_error_printer = LogXmlError;
   initGenericErrorDefaultFunc(&xml_error_printer);
+  // The error handler is per thread; the parsing threads start with this one.
+  xmlThrDefSetGenericErrorFunc(nullptr, xml_error_printer);
 
   try {
     // Parse command-line options.
@@ -39,6 +39,11 @@ Settings& Settings::algorithm(Algorithm value) noexcept {
         approximation(Approximation::kRareEvent);
       if (prime_implicants_)
         prime_implicants(false);
+      shared_sequences_ = false;
+      if (algorithm_ == Algorithm::kMocus ||
+          variable_order_ == VariableOrder::kTournament) {
+        variable_order_ = VariableOrder::kDfs;
+      }
   }
   return *this;
 }
@@ -69,6 +74,27 @@ Settings& Settings::approximation(std::string_view value) {
       static_cast<Approximation>(std::distance(kApproximationToString, it)));
 }
 
+Settings& Settings::variable_order(VariableOrder value) {
+  if (value != VariableOrder::kDfs && algorithm_ == Algorithm::kMocus)
+    SCRAM_THROW(SettingsError(
+        "MOCUS runs only with the 'dfs' variable ordering heuristic."));
+  if (value == VariableOrder::kTournament && algorithm_ != Algorithm::kBdd)
+    SCRAM_THROW(SettingsError(
+        "The variable ordering tournament is only available with BDD."));
+
+  variable_order_ = value;
+  return *this;
+}
+
+Settings& Settings::variable_order(std::string_view value) {
+  auto it = boost::find(kVariableOrderToString, value);
+  if (it == std::end(kVariableOrderToString))
+    SCRAM_THROW(SettingsError("The variable ordering heuristic '" +
+                              std::string(value) + "' is not recognized."));
+  return variable_order(
+      static_cast<VariableOrder>(std::distance(kVariableOrderToString, it)));
+}
+
 Settings& Settings::prime_implicants(bool flag) {
   if (flag && algorithm_ != Algorithm::kBdd)
     SCRAM_THROW(
@@ -80,6 +106,15 @@ Settings& Settings::prime_implicants(bool flag) {
   return *this;
 }
 
+Settings& Settings::shared_sequences(bool flag) {
+  if (flag && algorithm_ != Algorithm::kBdd)
+    SCRAM_THROW(SettingsError(
+        "Shared analysis of sequences is only available with BDD"));
+
+  shared_sequences_ = flag;
+  return *this;
+}
+
 Settings& Settings::limit_order(int order) {
   if (order < 0) {
     SCRAM_THROW(SettingsError(
@@ -89,11 +124,24 @@ Settings& Settings::limit_order(int order) {
   return *this;
 }
 
+Settings& Settings::top_products(int n) {
+  if (n < 0) {
+    SCRAM_THROW(SettingsError(
+        "The number of top products cannot be less than 0."));
+  }
+  top_products_ = n;
+  if (top_products_)
+    probability_analysis_ = true;
+  return *this;
+}
+
 Settings& Settings::cut_off(double prob) {
   if (prob < 0 || prob > 1)
     SCRAM_THROW(SettingsError(
         "The cut-off probability cannot be negative or more than 1."));
   cut_off_ = prob;
+  if (cut_off_)
+    probability_analysis_ = true;
   return *this;
 }
 
@@ -130,6 +178,22 @@ Settings& Settings::seed(int s) {
   return *this;
 }
 
+Settings& Settings::jobs(int n) {
+  if (n < 1)
+    SCRAM_THROW(SettingsError("The number of jobs cannot be less than 1."));
+
+  jobs_ = n;
+  return *this;
+}
+
+Settings& Settings::reorder_time(double time) {
+  if (time < 0)
+    SCRAM_THROW(SettingsError("The reordering time cannot be negative."));
+
+  reorder_time_ = time;
+  return *this;
+}
+
 Settings& Settings::mission_time(double time) {
   if (time < 0)
     SCRAM_THROW(SettingsError("The mission time cannot be negative."));
@@ -22,7 +22,9 @@
 
 #include <cstdint>
 
+#include <string>
 #include <string_view>
+#include <utility>
 
 namespace scram::core {
 
@@ -38,6 +40,18 @@ enum class Approximation : std::uint8_t { kNone = 0, kRareEvent, kMcub };
 /// String representations for approximations.
 const char* const kApproximationToString[] = {"none", "rare-event", "mcub"};
 
+/// Variable ordering heuristics for decision diagrams.
+enum class VariableOrder : std::uint8_t {
+  kDfs = 0,  ///< The depth-first topological order.
+  kForce,  ///< The FORCE center-of-gravity placement.
+  kFanIn,  ///< The weighted fan-in from the root.
+  kTournament  ///< The best of the above by trial BDD sizes.
+};
+
+/// String representations for variable ordering heuristics.
+const char* const kVariableOrderToString[] = {"dfs", "force", "fan-in",
+                                              "tournament"};
+
 /// Builder for analysis settings.
 /// Analysis facilities are guaranteed not to throw or fail
 /// with an instance of this class.
@@ -89,6 +103,42 @@ class Settings {
   Settings& approximation(std::string_view value);
   /// @}
 
+  /// @returns The variable ordering heuristic for decision diagrams.
+  VariableOrder variable_order() const { return variable_order_; }
+
+  /// Sets the heuristic to order variables for decision diagrams.
+  /// MOCUS inverts the gate order for its own needs
+  /// and runs only with the default depth-first order.
+  /// The tournament builds trial BDDs
+  /// and is available only with the BDD algorithm.
+  ///
+  /// @param[in] value  The variable ordering heuristic.
+  ///
+  /// @returns Reference to this object.
+  ///
+  /// @throws SettingsError  The heuristic is not recognized
+  ///                        or inappropriate for the algorithm.
+  /// @{
+  Settings& variable_order(VariableOrder value);
+  Settings& variable_order(std::string_view value);
+  /// @}
+
+  /// @returns The directory of the persistent cache
+  ///          of preprocessed PDAGs or an empty path to disable caching.
+  const std::string& cache_dir() const { return cache_dir_; }
+
+  /// Sets the directory to store and reuse preprocessed PDAGs
+  /// across analysis runs.
+  /// The directory is created upon the first store if it doesn't exist.
+  ///
+  /// @param[in] path  The cache directory or an empty path to disable caching.
+  ///
+  /// @returns Reference to this object.
+  Settings& cache_dir(std::string path) {
+    cache_dir_ = std::move(path);
+    return *this;
+  }
+
   /// @returns true if prime implicants are to be calculated
   ///               instead of minimal cut sets.
   bool prime_implicants() const { return prime_implicants_; }
@@ -106,6 +156,22 @@ class Settings {
   /// @throws SettingsError  The request is not relevant to the algorithm.
   Settings& prime_implicants(bool flag);
 
+  /// @returns true if the sequences of an event tree
+  ///               are to be analyzed with a single shared BDD.
+  bool shared_sequences() const { return shared_sequences_; }
+
+  /// Sets a flag to analyze the sequences of each initiating event
+  /// with one PDAG and BDD shared by all the sequences
+  /// instead of the full fault tree analysis per sequence.
+  /// The shared analysis is only available for the BDD algorithm.
+  ///
+  /// @param[in] flag  True for the request.
+  ///
+  /// @returns Reference to this object.
+  ///
+  /// @throws SettingsError  The request is not relevant to the algorithm.
+  Settings& shared_sequences(bool flag);
+
   /// @returns The limit on the size of products.
   int limit_order() const { return limit_order_; }
 
@@ -118,13 +184,32 @@ class Settings {
   /// @throws SettingsError  The number is less than 0.
   Settings& limit_order(int order);
 
+  /// @returns The number of the most probable products to report.
+  ///          0 means all the products.
+  int top_products() const { return top_products_; }
+
+  /// Sets the number of the most probable products
+  /// to be found and reported instead of all the products.
+  /// The request for the products turns on the probability analysis.
+  ///
+  /// @param[in] n  A non-negative number of products (0 for all products).
+  ///
+  /// @returns Reference to this object.
+  ///
+  /// @throws SettingsError  The number is less than 0.
+  Settings& top_products(int n);
+
   /// @returns The minimum required probability for products.
+  ///          0 means no cut-off.
   double cut_off() const { return cut_off_; }
 
   /// Sets the cut-off probability for products
   /// to be considered for analysis.
+  /// The products less probable than the cut-off
+  /// are discarded during the qualitative analysis.
+  /// The non-zero cut-off turns on the probability analysis.
   ///
-  /// @param[in] prob  The minimum probability for products.
+  /// @param[in] prob  The minimum probability for products (0 for no cut-off).
   ///
   /// @returns Reference to this object.
   ///
@@ -179,6 +264,35 @@ class Settings {
   /// @throws SettingsError  The number is negative.
   Settings& seed(int s);
 
+  /// @returns The number of worker threads for independent analyses.
+  int jobs() const { return jobs_; }
+
+  /// Sets the number of worker threads
+  /// to parse input files and run independent analysis targets concurrently.
+  ///
+  /// @param[in] n  A natural number for the number of threads.
+  ///
+  /// @returns Reference to this object.
+  ///
+  /// @throws SettingsError  The number is less than 1.
+  Settings& jobs(int n);
+
+  /// @returns The time limit in seconds for BDD variable reordering.
+  ///          0 means no reordering.
+  double reorder_time() const { return reorder_time_; }
+
+  /// Sets the time limit for reordering of BDD variables
+  /// to shrink large module functions after they are built.
+  /// The intermediate functions are not reordered
+  /// while a module function is being constructed.
+  ///
+  /// @param[in] time  A non-negative number of seconds (0 to disable).
+  ///
+  /// @returns Reference to this object.
+  ///
+  /// @throws SettingsError  The time is negative.
+  Settings& reorder_time(double time);
+
   /// @returns The length time of the system under risk.
   double mission_time() const { return mission_time_; }
 
@@ -220,7 +334,7 @@ class Settings {
   /// @returns Reference to this object.
   Settings& probability_analysis(bool flag) {
     if (!importance_analysis_ && !uncertainty_analysis_ &&
-        !safety_integrity_levels_) {
+        !safety_integrity_levels_ && !top_products_ && !cut_off_) {
       probability_analysis_ = flag;
     }
     return *this;
@@ -299,18 +413,25 @@ class Settings {
   bool uncertainty_analysis_ = false;  ///< A flag for uncertainty analysis.
   bool ccf_analysis_ = false;  ///< A flag for common-cause analysis.
   bool prime_implicants_ = false;  ///< Calculation of prime implicants.
+  bool shared_sequences_ = false;  ///< Shared analysis of sequences.
   /// Qualitative analysis algorithm.
   Algorithm algorithm_ = Algorithm::kBdd;
   /// The approximations for calculations.
   Approximation approximation_ = Approximation::kNone;
+  /// The variable ordering heuristic for decision diagrams.
+  VariableOrder variable_order_ = VariableOrder::kDfs;
   int limit_order_ = 20;  ///< Limit on the order of products.
+  int top_products_ = 0;  ///< The number of the most probable products.
   int seed_ = 0;  ///< The seed for the pseudo-random number generator.
+  int jobs_ = 1;  ///< The number of worker threads for analyses.
   int num_trials_ = 1e3;  ///< The number of trials for Monte Carlo simulations.
   int num_quantiles_ = 20;  ///< The number of quantiles for distributions.
   int num_bins_ = 20;  ///< The number of bins for histograms.
   double mission_time_ = 8760;  ///< System mission time.
   double time_step_ = 0;  ///< The time step for probability analyses.
-  double cut_off_ = 1e-8;  ///< The cut-off probability for products.
+  double cut_off_ = 0;  ///< The cut-off probability for products.
+  double reorder_time_ = 0;  ///< The time limit for BDD variable reordering.
+  std::string cache_dir_;  ///< The directory of preprocessed PDAGs.
 };
 
 }  // namespace scram::core
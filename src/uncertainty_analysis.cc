@@ -22,6 +22,9 @@
 
 #include <cmath>
 
+#include <algorithm>
+#include <random>
+
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/density.hpp>
 #include <boost/accumulators/statistics/extended_p_square_quantile.hpp>
@@ -31,16 +34,20 @@
 
 #include "event.h"
 #include "expression.h"
+#include "expression/random_deviate.h"
 #include "logger.h"
 
 namespace scram::core {
 
 UncertaintyAnalysis::UncertaintyAnalysis(
-    const ProbabilityAnalysis* prob_analysis)
+    const ProbabilityAnalysis* prob_analysis, int num_jobs, int stream)
     : Analysis(prob_analysis->settings()),
       mean_(0),
       sigma_(0),
-      error_factor_(1) {}
+      error_factor_(1),
+      stream_(stream) {
+  Analysis::settings().jobs(num_jobs);
+}
 
 void UncertaintyAnalysis::Analyze() noexcept {
   CLOCK(analysis_time);
@@ -58,9 +65,9 @@ void UncertaintyAnalysis::Analyze() noexcept {
   Analysis::AddAnalysisTime(DUR(analysis_time));
 }
 
-std::vector<std::pair<int, mef::Expression&>>
+UncertaintyAnalysis::DeviateExpressions
 UncertaintyAnalysis::GatherDeviateExpressions(const Pdag* graph) noexcept {
-  std::vector<std::pair<int, mef::Expression&>> deviate_expressions;
+  DeviateExpressions deviate_expressions;
   int index = Pdag::kVariableStartIndex;
   for (const mef::BasicEvent* event : graph->basic_events()) {
     if (event->expression().IsDeviate())
@@ -71,8 +78,8 @@ UncertaintyAnalysis::GatherDeviateExpressions(const Pdag* graph) noexcept {
 }
 
 void UncertaintyAnalysis::SampleExpressions(
-    const std::vector<std::pair<int, mef::Expression&>>& deviate_expressions,
-    Pdag::IndexMap<double>* p_vars) noexcept {
+    const DeviateExpressions& deviate_expressions,
+    std::vector<double>* samples) noexcept {
   // Reset distributions.
   for (const auto& expression : deviate_expressions)
     expression.second.Reset();
@@ -80,10 +87,45 @@ void UncertaintyAnalysis::SampleExpressions(
   // Sample all expressions with distributions.
   for (const auto& expression : deviate_expressions) {
     double prob = expression.second.Sample();
-    (*p_vars)[expression.first] = prob > 1 ? 1 : prob < 0 ? 0 : prob;
+    samples->push_back(prob > 1 ? 1 : prob < 0 ? 0 : prob);
   }
 }
 
+void UncertaintyAnalysis::SeedTrialBlock(int block) noexcept {
+  std::seed_seq seed_sequence{Analysis::settings().seed(), stream_, block};
+  mef::RandomDeviate::seed(seed_sequence);
+}
+
+template <>
+std::vector<double> UncertaintyAnalyzer<Bdd>::Sample() noexcept {
+  const int kNumLanes = 8;  // The batch size for the flat BDD calculations.
+  const FlatBdd& flat_bdd = prob_analyzer_->flat_bdd();
+  const Pdag::IndexMap<double>& p_vars = prob_analyzer_->p_vars();
+  return UncertaintyAnalysis::RunTrials(prob_analyzer_->graph(), [&] {
+    return [&, batch = std::vector<double>(), values = std::vector<double>()](
+               const DeviateExpressions& deviate_expressions,
+               const double* deviates, int num_trials,
+               double* samples) mutable {
+      int num_deviates = deviate_expressions.size();
+      for (int first = 0; first < num_trials; first += kNumLanes) {
+        int num_lanes = std::min(kNumLanes, num_trials - first);
+        batch.resize(p_vars.size() * num_lanes);
+        for (int i = 0; i < p_vars.size(); ++i)
+          std::fill_n(&batch[i * num_lanes], num_lanes, p_vars.data()[i]);
+        for (int j = 0; j < num_lanes; ++j) {
+          const double* trial = deviates + (first + j) * num_deviates;
+          for (int k = 0; k < num_deviates; ++k) {
+            int position =
+                deviate_expressions[k].first - Pdag::kVariableStartIndex;
+            batch[position * num_lanes + j] = trial[k];
+          }
+        }
+        flat_bdd.Calculate(batch.data(), num_lanes, &values, samples + first);
+      }
+    };
+  });
+}
+
 void UncertaintyAnalysis::CalculateStatistics(
     const std::vector<double>& samples) noexcept {
   using namespace boost;  // NOLINT
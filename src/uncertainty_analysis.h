@@ -21,10 +21,14 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <utility>
 #include <vector>
 
 #include "analysis.h"
+#include "ext/parallel.h"
 #include "probability_analysis.h"
 #include "settings.h"
 
@@ -44,7 +48,12 @@ class UncertaintyAnalysis : public Analysis {
   /// by probability analysis.
   ///
   /// @param[in] prob_analysis  Completed probability analysis.
-  explicit UncertaintyAnalysis(const ProbabilityAnalysis* prob_analysis);
+  /// @param[in] num_jobs  The number of threads for sampling
+  ///                      (the probability analysis may have used fewer).
+  /// @param[in] stream  The identifier of the analysis target
+  ///                    to draw random numbers independent of other targets.
+  UncertaintyAnalysis(const ProbabilityAnalysis* prob_analysis, int num_jobs,
+                      int stream);
 
   virtual ~UncertaintyAnalysis() = default;
 
@@ -76,23 +85,58 @@ class UncertaintyAnalysis : public Analysis {
   const std::vector<double>& quantiles() const { return quantiles_; }
 
  protected:
+  /// Deviate expressions of variables with the variable indices.
+  using DeviateExpressions = std::vector<std::pair<int, mef::Expression&>>;
+
   /// Gathers deviate expressions of variables.
   ///
   /// @param[in] graph  PDAG with the variables.
   ///
   /// @returns The gathered deviate expressions with variable indices.
-  std::vector<std::pair<int, mef::Expression&>>
-  GatherDeviateExpressions(const Pdag* graph) noexcept;
+  DeviateExpressions GatherDeviateExpressions(const Pdag* graph) noexcept;
 
   /// Samples uncertain probabilities.
   ///
   /// @param[in] deviate_expressions  A collection of deviate expressions.
-  /// @param[in,out] p_vars  Indices to probabilities mapping with values.
-  void SampleExpressions(
-      const std::vector<std::pair<int, mef::Expression&>>& deviate_expressions,
-      Pdag::IndexMap<double>* p_vars) noexcept;
+  /// @param[in,out] samples  The destination to append sampled probabilities
+  ///                         in the order of the deviate expressions.
+  void SampleExpressions(const DeviateExpressions& deviate_expressions,
+                         std::vector<double>* samples) noexcept;
+
+  /// Runs Monte Carlo trials in fixed-size blocks
+  /// concurrently on the number of jobs in the settings.
+  /// Each block of trials draws from its own random number stream
+  /// seeded with the seed from the settings, the target stream,
+  /// and the block number;
+  /// thus, the samples don't depend on the number of jobs,
+  /// and the samples of different targets are not correlated.
+  ///
+  /// @tparam F  The factory of reentrant block calculators
+  ///            of the total probability
+  ///            (callable as void(const DeviateExpressions&,
+  ///                              const double* deviates,
+  ///                              int num_trials, double* samples))
+  ///            to create one calculator per worker thread
+  ///            reused for all the blocks of the worker.
+  ///            The deviate values are given in the trial-major order.
+  ///
+  /// @param[in] graph  PDAG with the variables.
+  /// @param[in] make_calculator  The factory of calculators.
+  ///
+  /// @returns The sampled total probabilities in the order of trials.
+  template <class F>
+  std::vector<double> RunTrials(const Pdag* graph, F make_calculator) noexcept;
 
  private:
+  /// The number of trials sharing a random number stream.
+  static constexpr int kTrialBlockSize = 64;
+
+  /// Seeds the random number generator of deviate expressions
+  /// with a stream unique to the target and a block of trials.
+  ///
+  /// @param[in] block  The block number of trials.
+  void SeedTrialBlock(int block) noexcept;
+
   /// Performs Monte Carlo Simulation
   /// by sampling the probability distributions
   /// and providing the final sampled values of the final probability.
@@ -114,6 +158,7 @@ class UncertaintyAnalysis : public Analysis {
   std::vector<std::pair<double, double>> distribution_;
   /// The quantiles of the distribution.
   std::vector<double> quantiles_;
+  int stream_;  ///< The random number stream of the analysis target.
 };
 
 /// Uncertainty analysis facility.
@@ -127,8 +172,12 @@ class UncertaintyAnalyzer : public UncertaintyAnalysis {
   /// to calculate the total probability for sampling.
   ///
   /// @param[in] prob_analyzer  Instantiated probability analyzer.
-  explicit UncertaintyAnalyzer(ProbabilityAnalyzer<Calculator>* prob_analyzer)
-      : UncertaintyAnalysis(prob_analyzer), prob_analyzer_(prob_analyzer) {}
+  /// @param[in] num_jobs  The number of threads for sampling.
+  /// @param[in] stream  The random number stream of the analysis target.
+  UncertaintyAnalyzer(ProbabilityAnalyzer<Calculator>* prob_analyzer,
+                      int num_jobs, int stream)
+      : UncertaintyAnalysis(prob_analyzer, num_jobs, stream),
+        prob_analyzer_(prob_analyzer) {}
 
  private:
   /// @returns Samples of the total probability.
@@ -138,22 +187,62 @@ class UncertaintyAnalyzer : public UncertaintyAnalysis {
   ProbabilityAnalyzer<Calculator>* prob_analyzer_;
 };
 
+template <class F>
+std::vector<double> UncertaintyAnalysis::RunTrials(const Pdag* graph,
+                                                   F make_calculator) noexcept {
+  DeviateExpressions deviate_expressions = GatherDeviateExpressions(graph);
+  int num_trials = Analysis::settings().num_trials();
+  int num_blocks = (num_trials + kTrialBlockSize - 1) / kTrialBlockSize;
+  std::vector<double> samples(num_trials);
+  std::mutex sample_mutex;  // Deviates share the RNG and sampled values.
+
+  // The workers take the next block one at a time to balance the load.
+  int num_workers = std::min(Analysis::settings().jobs(), num_blocks);
+  std::atomic<int> next_block = 0;
+  ext::parallel_for(num_workers, num_workers, [&](int) {
+    auto calculator = make_calculator();
+    std::vector<double> deviates;
+    deviates.reserve(kTrialBlockSize * deviate_expressions.size());
+    for (int block = next_block++; block < num_blocks; block = next_block++) {
+      int first = block * kTrialBlockSize;
+      int last = std::min(first + kTrialBlockSize, num_trials);
+      deviates.clear();
+      {
+        std::lock_guard<std::mutex> lock(sample_mutex);
+        SeedTrialBlock(block);
+        for (int i = first; i < last; ++i)
+          SampleExpressions(deviate_expressions, &deviates);
+      }
+      calculator(deviate_expressions, deviates.data(), last - first,
+                 samples.data() + first);
+    }
+  });
+
+  assert(std::all_of(samples.begin(), samples.end(),
+                     [](double result) { return result >= 0 && result <= 1; }));
+  return samples;
+}
+
 template <class Calculator>
 std::vector<double> UncertaintyAnalyzer<Calculator>::Sample() noexcept {
-  std::vector<std::pair<int, mef::Expression&>> deviate_expressions =
-      UncertaintyAnalysis::GatherDeviateExpressions(prob_analyzer_->graph());
-  Pdag::IndexMap<double> p_vars = prob_analyzer_->p_vars();  // Private copy!
-  std::vector<double> samples;
-  samples.reserve(Analysis::settings().num_trials());
-
-  for (int i = 0; i < Analysis::settings().num_trials(); ++i) {
-    UncertaintyAnalysis::SampleExpressions(deviate_expressions, &p_vars);
-    double result = prob_analyzer_->CalculateTotalProbability(p_vars);
-    assert(result >= 0 && result <= 1);
-    samples.push_back(result);
-  }
-
-  return samples;
+  return UncertaintyAnalysis::RunTrials(prob_analyzer_->graph(), [this] {
+    return [this, p_vars = prob_analyzer_->p_vars()](
+               const DeviateExpressions& deviate_expressions,
+               const double* deviates, int num_trials,
+               double* samples) mutable {
+      for (int i = 0; i < num_trials; ++i) {
+        for (const auto& expression : deviate_expressions)
+          p_vars[expression.first] = *deviates++;
+        samples[i] = prob_analyzer_->CalculateTotalProbability(p_vars);
+      }
+    };
+  });
 }
 
+/// Samples with the flat copy of the BDD in batches of trials
+/// because the recursive calculation is not reentrant
+/// and evaluates one trial per traversal.
+template <>
+std::vector<double> UncertaintyAnalyzer<Bdd>::Sample() noexcept;
+
 }  // namespace scram::core
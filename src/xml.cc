@@ -45,8 +45,7 @@ Document::Document(const std::string& file_path, Validator* validator)
 }
 
 Validator::Validator(const std::string& rng_file)
-    : schema_(nullptr, &xmlRelaxNGFree),
-      valid_ctxt_(nullptr, &xmlRelaxNGFreeValidCtxt) {
+    : valid_ctxt_(nullptr, &xmlRelaxNGFreeValidCtxt) {
   xmlResetLastError();
   std::unique_ptr<xmlRelaxNGParserCtxt, decltype(&xmlRelaxNGFreeParserCtxt)>
       parser_ctxt(xmlRelaxNGNewParserCtxt(rng_file.c_str()),
@@ -54,7 +53,7 @@ Validator::Validator(const std::string& rng_file)
   if (!parser_ctxt)
     SCRAM_THROW(detail::GetError<LogicError>());
 
-  schema_.reset(xmlRelaxNGParse(parser_ctxt.get()));
+  schema_.reset(xmlRelaxNGParse(parser_ctxt.get()), &xmlRelaxNGFree);
   if (!schema_)
     SCRAM_THROW(detail::GetError<ParseError>());
 
@@ -63,4 +62,12 @@ Validator::Validator(const std::string& rng_file)
     SCRAM_THROW(detail::GetError<LogicError>());
 }
 
+Validator::Validator(const Validator& other)
+    : schema_(other.schema_),
+      valid_ctxt_(xmlRelaxNGNewValidCtxt(schema_.get()),
+                  &xmlRelaxNGFreeValidCtxt) {
+  if (!valid_ctxt_)
+    SCRAM_THROW(detail::GetError<LogicError>());
+}
+
 }  // namespace scram::xml
@@ -447,6 +447,15 @@ class Validator {
   /// @throws LogicError  The XML library functions have failed internally.
   explicit Validator(const std::string& rng_file);
 
+  /// Creates a validator with its own validation context
+  /// sharing the parsed schema of another validator.
+  /// Validators with separate contexts can validate documents concurrently.
+  ///
+  /// @param[in] other  The validator with the schema.
+  ///
+  /// @throws LogicError  The XML library functions have failed internally.
+  Validator(const Validator& other);
+
   /// Validates XML DOM documents against the schema.
   ///
   /// @param[in] doc  The initialized XML DOM document.
@@ -462,7 +471,7 @@ class Validator {
 
  private:
   /// The schema used by the validation context.
-  std::unique_ptr<xmlRelaxNG, decltype(&xmlRelaxNGFree)> schema_;
+  std::shared_ptr<xmlRelaxNG> schema_;
   /// The validation context.
   std::unique_ptr<xmlRelaxNGValidCtxt, decltype(&xmlRelaxNGFreeValidCtxt)>
       valid_ctxt_;
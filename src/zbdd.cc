@@ -23,15 +23,55 @@
 #include <cstdlib>
 
 #include <algorithm>
+#include <limits>
+#include <queue>
 
 #include <boost/range/algorithm.hpp>
 
+#include "event.h"
 #include "ext/algorithm.h"
 #include "ext/find_iterator.h"
 #include "logger.h"
 
 namespace scram::core {
 
+std::shared_ptr<const ProbabilityWeights>
+ProbabilityWeights::Create(const Pdag& graph,
+                           const Settings& settings) noexcept {
+  if (!settings.cut_off())
+    return nullptr;
+  Pdag::IndexMap<double> p_vars;
+  p_vars.reserve(graph.basic_events().size());
+  for (const mef::BasicEvent* event : graph.basic_events())
+    p_vars.push_back(event->p());
+  auto weights =
+      std::make_shared<const ProbabilityWeights>(p_vars, settings.cut_off());
+  // The order and weight limits share the memoization keys.
+  if ((static_cast<std::int64_t>(weights->limit()) + 1) *
+          (settings.limit_order() + 1) >
+      std::numeric_limits<int>::max()) {
+    LOG(WARNING) << "The product order limit is too large "
+                    "for the cut-off probability; no truncation is applied.";
+    return nullptr;
+  }
+  return weights;
+}
+
+ProbabilityWeights::ProbabilityWeights(const Pdag::IndexMap<double>& p_vars,
+                                       double cut_off) noexcept
+    : limit_(std::floor(-std::log2(cut_off) * kScale)) {
+  assert(cut_off > 0 && cut_off <= 1);
+  assert(limit_ < SetNode::kMaxBound && "Saturated weights of literals.");
+  // Impossible literals are heavier than any acceptable product.
+  auto weight = [this](double p) {
+    double bits = -std::log2(p) * kScale;
+    return bits > limit_ ? limit_ + 1 : static_cast<int>(std::floor(bits));
+  };
+  weights_.reserve(p_vars.size());
+  for (double p : p_vars)
+    weights_.push_back({weight(p), weight(1 - p)});
+}
+
 #ifndef NDEBUG
 /// Runs assertions on ZBDD structure.
 ///
@@ -52,6 +92,10 @@ void Zbdd::Log() noexcept {
   LOG(DEBUG4) << "# of entries in OR table: " << or_table_.size();
   LOG(DEBUG4) << "# of entries in subsume table: " << subsume_table_.size();
   LOG(DEBUG4) << "# of entries in minimal table: " << minimal_results_.size();
+  LOG(DEBUG4) << "# of SetNode allocations: " << pool_->stats().allocations
+              << " (reused: " << pool_->stats().reuses
+              << ", peak live: " << pool_->stats().max_live
+              << ", slabs: " << pool_->stats().slabs << ")";
   ClearMarks(root_, false);
   LOG(DEBUG4) << "# of SetNodes in ZBDD: " << CountSetNodes(root_);
   ClearMarks(root_, false);
@@ -59,13 +103,17 @@ void Zbdd::Log() noexcept {
   ClearMarks(root_, false);
 }
 
-Zbdd::Zbdd(Bdd* bdd, const Settings& settings) noexcept
-    : Zbdd(bdd->root(), bdd->coherent(), bdd, settings) {
+Zbdd::Zbdd(Bdd* bdd, const Settings& settings, const Pdag* graph) noexcept
+    : Zbdd(bdd->root(), bdd->coherent(), bdd, settings,
+           graph ? ProbabilityWeights::Create(*graph, settings) : nullptr,
+           std::numeric_limits<int>::max()) {
   CHECK_ZBDD(true);
 }
 
 Zbdd::Zbdd(const Pdag* graph, const Settings& settings) noexcept
-    : Zbdd(graph->root(), settings) {
+    : Zbdd(graph->root(), settings,
+           ProbabilityWeights::Create(*graph, settings),
+           std::numeric_limits<int>::max()) {
   assert(!graph->complement() && "Complements must be propagated.");
   if (graph->IsTrivial()) {
     const Gate& top_gate = graph->root();
@@ -93,7 +141,7 @@ void Zbdd::Analyze(const Pdag* graph) noexcept {
   for (const auto& entry : modules_)
     entry.second->Analyze();
 
-  Prune(root_, kSettings_.limit_order());
+  root_ = Prune(root_, kSettings_.limit_order(), limit_weight_);
   if (graph)
     ApplySubstitutions(graph->substitutions());
 
@@ -101,46 +149,55 @@ void Zbdd::Analyze(const Pdag* graph) noexcept {
   LOG(DEBUG3) << "G" << module_index_ << " analysis time: " << DUR(zbdd_time);
 }
 
-Zbdd::Zbdd(const Settings& settings, bool coherent, int module_index) noexcept
+Zbdd::Zbdd(const Settings& settings, bool coherent, int module_index,
+           std::shared_ptr<const ProbabilityWeights> weights,
+           int limit_weight) noexcept
     : kBase_(new Terminal<SetNode>(true)),
       kEmpty_(new Terminal<SetNode>(false)),
       kSettings_(settings),
       root_(kEmpty_),
       coherent_(coherent),
       module_index_(module_index),
-      set_id_(2) {}
+      set_id_(2),
+      weights_(std::move(weights)),
+      limit_weight_(weights_ ? std::min(limit_weight, weights_->limit()) : 0),
+      pool_(VertexPool<SetNode>::Create()) {}
 
 Zbdd::Zbdd(const Bdd::Function& module, bool coherent, Bdd* bdd,
-           const Settings& settings, int module_index) noexcept
-    : Zbdd(settings, coherent, module_index) {
+           const Settings& settings,
+           std::shared_ptr<const ProbabilityWeights> weights, int limit_weight,
+           int module_index) noexcept
+    : Zbdd(settings, coherent, module_index, std::move(weights),
+           limit_weight) {
   CLOCK(init_time);
   LOG(DEBUG2) << "Creating ZBDD from BDD: G" << module_index;
   LOG(DEBUG4) << "Limit on product order: " << settings.limit_order();
   PairTable<VertexPtr> ites;
   root_ = Minimize(ConvertBdd(module.vertex, module.complement, bdd,
-                              kSettings_.limit_order(), &ites));
+                              kSettings_.limit_order(), limit_weight_, &ites));
   assert(root_->terminal() || SetNode::Ref(root_).minimal());
   Log();
   LOG(DEBUG2) << "Created ZBDD from BDD in " << DUR(init_time);
-  std::map<int, std::pair<bool, int>> sub_modules;
-  GatherModules(root_, 0, &sub_modules);
+  std::map<int, ModuleLimits> sub_modules;
+  GatherModules(root_, 0, 0, &sub_modules);
   for (const auto& entry : sub_modules) {
     int index = entry.first;
     assert(!modules_.count(index) && "Recalculating modules.");
     Bdd::Function sub = bdd->modules().find(std::abs(index))->second;
     assert(!sub.vertex->terminal() && "Unexpected BDD terminal vertex.");
-    int limit = entry.second.second;
-    assert(limit >= 0 && "Order cut-off is not strict.");
-    bool module_coherence = entry.second.first && (index > 0);
-    if (limit == 0 && module_coherence) {  // Unity is impossible.
+    const ModuleLimits& limits = entry.second;
+    assert(limits.order >= 0 && "Order cut-off is not strict.");
+    bool module_coherence = limits.coherent && (index > 0);
+    if (limits.order == 0 && module_coherence) {  // Unity is impossible.
       JoinModule(index, std::unique_ptr<Zbdd>(new Zbdd(settings)));
       continue;
     }
     Settings adjusted(settings);
-    adjusted.limit_order(limit);
+    adjusted.limit_order(limits.order);
     sub.complement ^= index < 0;
-    JoinModule(index, std::unique_ptr<Zbdd>(new Zbdd(sub, module_coherence, bdd,
-                                                     adjusted, index)));
+    JoinModule(index, std::unique_ptr<Zbdd>(
+                          new Zbdd(sub, module_coherence, bdd, adjusted,
+                                   weights_, limits.weight, index)));
   }
   if (ext::any_of(modules_, [](const ModuleEntry& member) {
         return member.second->root_->terminal();
@@ -151,8 +208,11 @@ Zbdd::Zbdd(const Bdd::Function& module, bool coherent, Bdd* bdd,
   }
 }
 
-Zbdd::Zbdd(const Gate& gate, const Settings& settings) noexcept
-    : Zbdd(settings, gate.coherent(), gate.index()) {
+Zbdd::Zbdd(const Gate& gate, const Settings& settings,
+           std::shared_ptr<const ProbabilityWeights> weights,
+           int limit_weight) noexcept
+    : Zbdd(settings, gate.coherent(), gate.index(), std::move(weights),
+           limit_weight) {
   if (gate.constant() || gate.type() == kNull)
     return;
   assert(!settings.prime_implicants() && "Not implemented.");
@@ -172,29 +232,163 @@ Zbdd::Zbdd(const Gate& gate, const Settings& settings) noexcept
   root_ = Minimize(root_);
   Log();
   LOG(DEBUG3) << "Finished module conversion to ZBDD in " << DUR(init_time);
-  std::map<int, std::pair<bool, int>> sub_modules;
-  GatherModules(root_, 0, &sub_modules);
+  std::map<int, ModuleLimits> sub_modules;
+  GatherModules(root_, 0, 0, &sub_modules);
+  std::vector<std::pair<const Gate*, ModuleLimits>> modules;
   for (const auto& entry : sub_modules) {
     int index = entry.first;
     assert(index > 0 && "No complement gates.");
     assert(!modules_.count(index) && "Recalculating modules.");
-    int limit = entry.second.second;
-    assert(limit >= 0 && "Order cut-off is not strict.");
-    bool coherent = entry.second.first;
-    if (limit == 0 && coherent) {  // Unity is impossible.
+    const ModuleLimits& limits = entry.second;
+    assert(limits.order >= 0 && "Order cut-off is not strict.");
+    if (limits.order == 0 && limits.coherent) {  // Unity is impossible.
       JoinModule(index, std::unique_ptr<Zbdd>(new Zbdd(settings)));
       continue;
     }
-    const Gate* module_gate = module_gates.find(index)->second;
-    Settings adjusted(settings);
-    adjusted.limit_order(limit);
-    JoinModule(index, std::unique_ptr<Zbdd>(new Zbdd(*module_gate, adjusted)));
+    modules.emplace_back(module_gates.find(index)->second, limits);
   }
+  // The module ZBDDs are independent and share no vertices or tables.
+  std::vector<std::unique_ptr<Zbdd>> results = zbdd::AnalyzeModules<Zbdd>(
+      modules, settings,
+      [this](const Gate* module, const ModuleLimits& limits,
+             const Settings& adjusted) {
+        return std::unique_ptr<Zbdd>(
+            new Zbdd(*module, adjusted, weights_, limits.weight));
+      });
+  for (int i = 0; i < modules.size(); ++i)
+    JoinModule(modules[i].first->index(), std::move(results[i]));
   EliminateConstantModules();
 }
 
 #undef CHECK_ZBDD
 
+double Zbdd::truncated_probability() const noexcept {
+  double p = truncated_p_;
+  for (const auto& entry : modules_)
+    p += entry.second->truncated_probability();
+  return p;
+}
+
+std::vector<std::vector<int>>
+Zbdd::FindTopProducts(int num_products,
+                      const Pdag::IndexMap<double>& p_vars) const noexcept {
+  using VertexRef = const Vertex<SetNode>*;
+  auto p_literal = [&p_vars](int index) {
+    return index > 0 ? p_vars[index] : 1 - p_vars[-index];
+  };
+  // The maximum probability of the products in the sub-graphs.
+  std::unordered_map<VertexRef, double> bounds;
+  auto bound = [&bounds, &p_literal](auto& self, VertexRef vertex,
+                                     const Zbdd& zbdd) -> double {
+    if (vertex->terminal())
+      return static_cast<const Terminal<SetNode>*>(vertex)->value();
+    if (auto it = ext::find(bounds, vertex))
+      return it->second;
+    auto* node = static_cast<const SetNode*>(vertex);
+    double p_high = 1;
+    if (node->module()) {
+      const Zbdd& module = *zbdd.modules_.find(node->index())->second;
+      p_high = self(self, module.root_.get(), module);
+    } else {
+      p_high = p_literal(node->index());
+    }
+    double result = std::max(p_high * self(self, node->high().get(), zbdd),
+                             self(self, node->low().get(), zbdd));
+    bounds.emplace(vertex, result);
+    return result;
+  };
+
+  // The partial products share their literal and pending vertex lists.
+  struct Task {  ///< The vertex to continue the product with.
+    VertexRef vertex;  ///< The pending vertex.
+    const Zbdd& zbdd;  ///< The host ZBDD of the vertex.
+    int next;  ///< The next pending task or -1.
+    double bound;  ///< The bound of this and the next pending tasks.
+  };
+  struct Link {  ///< The literal in a partial product.
+    int literal;  ///< The index of the literal.
+    int next;  ///< The previous literal in the product or -1.
+  };
+  struct State {  ///< The partial product in the search.
+    double bound;  ///< The upper bound of the product probability.
+    double p;  ///< The probability of the collected literals.
+    int order;  ///< The number of the collected literals.
+    int weight;  ///< The weight of the collected literals.
+    int task;  ///< The pending tasks or -1 for the complete product.
+    int link;  ///< The collected literals or -1.
+    int id;  ///< The creation order to break the ties.
+    bool operator<(const State& other) const {
+      return bound < other.bound || (bound == other.bound && id > other.id);
+    }
+  };
+  std::vector<Task> tasks;
+  std::vector<Link> links;
+  std::priority_queue<State> queue;
+  auto push_task = [&tasks, &bound](VertexRef vertex, const Zbdd& zbdd,
+                                    int next) {
+    double task_bound = bound(bound, vertex, zbdd);
+    if (next != -1)
+      task_bound *= tasks[next].bound;
+    tasks.push_back({vertex, zbdd, next, task_bound});
+    return static_cast<int>(tasks.size()) - 1;
+  };
+  int num_states = 0;
+  auto push_state = [&tasks, &queue, &num_states](double p, int order,
+                                                   int weight, int task,
+                                                   int link) {
+    if (task == -1) {
+      queue.push({p, p, order, weight, task, link, num_states++});
+    } else if (!tasks[task].vertex->terminal() ||
+               static_cast<const Terminal<SetNode>*>(tasks[task].vertex)
+                   ->value()) {  // The Empty set has no products.
+      queue.push({p * tasks[task].bound, p, order, weight, task, link,
+                  num_states++});
+    }
+  };
+  push_state(1, 0, 0, push_task(root_.get(), *this, -1), -1);
+
+  const int limit_order = kSettings_.limit_order();
+  std::vector<std::vector<int>> products;
+  while (!queue.empty() && products.size() < num_products) {
+    State state = queue.top();
+    queue.pop();
+    if (state.task == -1) {
+      std::vector<int> product(state.order);
+      for (int i = state.link, j = state.order - 1; i != -1;
+           i = links[i].next, --j) {
+        product[j] = links[i].literal;
+      }
+      products.push_back(std::move(product));
+      continue;
+    }
+    const Task& task = tasks[state.task];
+    if (task.vertex->terminal()) {  // Only the Base can be pending.
+      push_state(state.p, state.order, state.weight, task.next, state.link);
+      continue;
+    }
+    if (state.order >= limit_order)  // Mirrors the product iterators.
+      continue;
+    auto* node = static_cast<const SetNode*>(task.vertex);
+    const Zbdd& zbdd = task.zbdd;
+    int next = task.next;  // The task reference is invalidated by pushes.
+    push_state(state.p, state.order, state.weight,
+               push_task(node->low().get(), zbdd, next), state.link);
+    if (node->module()) {
+      const Zbdd& module = *zbdd.modules_.find(node->index())->second;
+      int high = push_task(node->high().get(), zbdd, next);
+      push_state(state.p, state.order, state.weight,
+                 push_task(module.root_.get(), module, high), state.link);
+    } else if (int weight = state.weight + GetWeight(node->index());
+               weight <= limit_weight_) {  // Mirrors the product iterators.
+      int high = push_task(node->high().get(), zbdd, next);
+      links.push_back({node->index(), state.link});
+      push_state(state.p * p_literal(node->index()), state.order + 1, weight,
+                 high, static_cast<int>(links.size()) - 1);
+    }
+  }
+  return products;
+}
+
 SetNodePtr Zbdd::FindOrAddVertex(int index, const VertexPtr& high,
                                  const VertexPtr& low, int order, bool module,
                                  bool coherent) noexcept {
@@ -205,13 +399,18 @@ SetNodePtr Zbdd::FindOrAddVertex(int index, const VertexPtr& high,
   if (!in_table.expired())
     return in_table.lock();
   assert(order > 0 && "Improper order.");
-  SetNodePtr node(new SetNode(index, order, set_id_++, high, low));
+  SetNodePtr node(
+      new (pool_.get()) SetNode(index, order, set_id_++, high, low));
   node->module(module);
   node->coherent(coherent);
   int high_order = high->terminal() ? 0 : SetNode::Ref(high).max_set_order();
   high_order += !MayBeUnity(*node);
   int low_order = low->terminal() ? 0 : SetNode::Ref(low).max_set_order();
   node->max_set_order(std::max(high_order, low_order));
+  int high_weight = high->terminal() ? 0 : SetNode::Ref(high).max_set_weight();
+  high_weight += GetWeight(*node);
+  int low_weight = low->terminal() ? 0 : SetNode::Ref(low).max_set_weight();
+  node->max_set_weight(std::max(high_weight, low_weight));
 
   in_table = node;
   return node;
@@ -261,63 +460,76 @@ Zbdd::VertexPtr Zbdd::GetReducedVertex(const SetNodePtr& node,
 
 Zbdd::VertexPtr Zbdd::ConvertBdd(const Bdd::VertexPtr& vertex, bool complement,
                                  Bdd* bdd_graph, int limit_order,
+                                 int limit_weight,
                                  PairTable<VertexPtr>* ites) noexcept {
+  if (limit_weight < 0)  // Cut-off on the set probability.
+    return Truncate(limit_weight, !vertex->terminal() || !complement);
   if (vertex->terminal())
     return complement ? kEmpty_ : kBase_;
-  VertexPtr& result =
-      (*ites)[{complement ? -vertex->id() : vertex->id(), limit_order}];
+  VertexPtr& result = (*ites)[{complement ? -vertex->id() : vertex->id(),
+                               GetLimitKey(limit_order, limit_weight)}];
   if (result)
     return result;
   if (!coherent_ && kSettings_.prime_implicants()) {
     result = ConvertBddPrimeImplicants(Ite::Ptr(vertex), complement, bdd_graph,
-                                       limit_order, ites);
+                                       limit_order, limit_weight, ites);
   } else {
-    result =
-        ConvertBdd(Ite::Ptr(vertex), complement, bdd_graph, limit_order, ites);
+    result = ConvertBdd(Ite::Ptr(vertex), complement, bdd_graph, limit_order,
+                        limit_weight, ites);
   }
   assert(result->terminal() ||
          SetNode::Ref(result).max_set_order() <= limit_order);
+  assert(result->terminal() ||
+         SetNode::Ref(result).max_set_weight() <= limit_weight);
   return result;
 }
 
 Zbdd::VertexPtr Zbdd::ConvertBdd(const ItePtr& ite, bool complement,
                                  Bdd* bdd_graph, int limit_order,
+                                 int limit_weight,
                                  PairTable<VertexPtr>* ites) noexcept {
   if (ite->module() && !ite->coherent())
     return ConvertBddPrimeImplicants(ite, complement, bdd_graph, limit_order,
-                                     ites);
+                                     limit_weight, ites);
   VertexPtr low = ConvertBdd(ite->low(), ite->complement_edge() ^ complement,
-                             bdd_graph, limit_order, ites);
+                             bdd_graph, limit_order, limit_weight, ites);
   if (limit_order == 0) {  // Cut-off on the set order.
     if (low->terminal())
       return low;
     return kEmpty_;
   }
-  VertexPtr high =
-      ConvertBdd(ite->high(), complement, bdd_graph, --limit_order, ites);
+  int high_weight = ite->module() ? 0 : GetWeight(ite->index());
+  VertexPtr high = ConvertBdd(ite->high(), complement, bdd_graph, --limit_order,
+                              limit_weight - high_weight, ites);
   return GetReducedVertex(ite, false, high, low);
 }
 
 Zbdd::VertexPtr Zbdd::ConvertBddPrimeImplicants(
     const ItePtr& ite, bool complement, Bdd* bdd_graph, int limit_order,
-    PairTable<VertexPtr>* ites) noexcept {
+    int limit_weight, PairTable<VertexPtr>* ites) noexcept {
   Bdd::Function common = Bdd::Consensus()(bdd_graph, ite, complement);
   VertexPtr consensus = ConvertBdd(common.vertex, common.complement, bdd_graph,
-                                   limit_order, ites);
+                                   limit_order, limit_weight, ites);
   if (limit_order == 0) {  // Cut-off on the product order.
     if (consensus->terminal())
       return consensus;
     return kEmpty_;
   }
   int sublimit = limit_order - 1;  // Assumes non-Unity element.
+  int high_weight = 0;
+  int low_weight = 0;
   if (ite->module() && !kSettings_.prime_implicants()) {
     assert(!ite->coherent() && "Only non-coherent modules through PI.");
     sublimit += 1;  // Unity modules may happen with minimal cut sets.
+  } else if (!ite->module()) {
+    high_weight = GetWeight(ite->index());
+    low_weight = GetWeight(-ite->index());
   }
-  VertexPtr high =
-      ConvertBdd(ite->high(), complement, bdd_graph, sublimit, ites);
+  VertexPtr high = ConvertBdd(ite->high(), complement, bdd_graph, sublimit,
+                              limit_weight - high_weight, ites);
   VertexPtr low = ConvertBdd(ite->low(), ite->complement_edge() ^ complement,
-                             bdd_graph, sublimit, ites);
+                             bdd_graph, sublimit, limit_weight - low_weight,
+                             ites);
   return GetReducedVertex(ite, false, high,
                           GetReducedVertex(ite, true, low, consensus));
 }
@@ -358,7 +570,8 @@ Zbdd::VertexPtr Zbdd::ConvertGraph(
   });
   auto it = args.cbegin();
   for (result = *it++; it != args.cend(); ++it) {
-    result = Apply(gate.type(), result, *it, kSettings_.limit_order());
+    result = Apply(gate.type(), result, *it, kSettings_.limit_order(),
+                   limit_weight_);
   }
   ClearTables();
   assert(result);
@@ -370,14 +583,15 @@ Zbdd::VertexPtr Zbdd::ConvertGraph(
 }
 
 Triplet Zbdd::GetResultKey(const VertexPtr& arg_one, const VertexPtr& arg_two,
-                           int order) noexcept {
+                           int order, int weight) noexcept {
   assert(order >= 0 && "Illegal order for computations.");
+  assert(weight >= 0 && "Illegal weight for computations.");
   assert(!arg_one->terminal() && !arg_two->terminal());
   assert(arg_one->id() && arg_two->id());
   assert(arg_one->id() != arg_two->id());
   int min_id = std::min(arg_one->id(), arg_two->id());
   int max_id = std::max(arg_one->id(), arg_two->id());
-  return {min_id, max_id, order};
+  return {min_id, max_id, GetLimitKey(order, weight)};
 }
 
 /// Forward declarations of interdependent Apply operation specializations.
@@ -385,41 +599,46 @@ Triplet Zbdd::GetResultKey(const VertexPtr& arg_one, const VertexPtr& arg_two,
 template <>
 Zbdd::VertexPtr Zbdd::Apply<kAnd>(const VertexPtr& arg_one,
                                   const VertexPtr& arg_two,
-                                  int limit_order) noexcept;
+                                  int limit_order, int limit_weight) noexcept;
 template <>
 Zbdd::VertexPtr Zbdd::Apply<kOr>(const VertexPtr& arg_one,
-                                 const VertexPtr& arg_two,
-                                 int limit_order) noexcept;
+                                 const VertexPtr& arg_two, int limit_order,
+                                 int limit_weight) noexcept;
 /// @}
 
 /// Specialization of Apply for AND operator for non-terminal ZBDD vertices.
 template <>
 Zbdd::VertexPtr Zbdd::Apply<kAnd>(const SetNodePtr& arg_one,
-                                  const SetNodePtr& arg_two,
-                                  int limit_order) noexcept {
+                                  const SetNodePtr& arg_two, int limit_order,
+                                  int limit_weight) noexcept {
   VertexPtr high;
   VertexPtr low;
   int limit_high = limit_order - !MayBeUnity(*arg_one);
+  int weight_high = limit_weight - GetWeight(*arg_one);
   if (arg_one->order() == arg_two->order() &&
       arg_one->index() == arg_two->index()) {  // The same variable.
     // (x*f1 + f0) * (x*g1 + g0) = x*(f1*(g1 + g0) + f0*g1) + f0*g0
     high = Apply<kOr>(
         Apply<kAnd>(arg_one->high(),
-                    Apply<kOr>(arg_two->high(), arg_two->low(), limit_high),
-                    limit_high),
-        Apply<kAnd>(arg_one->low(), arg_two->high(), limit_high), limit_high);
-    low = Apply<kAnd>(arg_one->low(), arg_two->low(), limit_order);
+                    Apply<kOr>(arg_two->high(), arg_two->low(), limit_high,
+                               weight_high),
+                    limit_high, weight_high),
+        Apply<kAnd>(arg_one->low(), arg_two->high(), limit_high, weight_high),
+        limit_high, weight_high);
+    low = Apply<kAnd>(arg_one->low(), arg_two->low(), limit_order,
+                      limit_weight);
   } else {
     assert((arg_one->order() < arg_two->order() ||
             arg_one->index() > arg_two->index()) &&
            "Ordering contract failed.");
     if (arg_one->order() == arg_two->order()) {
       // (x*f1 + f0) * (~x*g1 + g0) = x*f1*g0 + f0*(~x*g1 + g0)
-      high = Apply<kAnd>(arg_one->high(), arg_two->low(), limit_high);
+      high = Apply<kAnd>(arg_one->high(), arg_two->low(), limit_high,
+                         weight_high);
     } else {
-      high = Apply<kAnd>(arg_one->high(), arg_two, limit_high);
+      high = Apply<kAnd>(arg_one->high(), arg_two, limit_high, weight_high);
     }
-    low = Apply<kAnd>(arg_one->low(), arg_two, limit_order);
+    low = Apply<kAnd>(arg_one->low(), arg_two, limit_order, limit_weight);
   }
   if (!high->terminal() && SetNode::Ref(high).order() == arg_one->order()) {
     assert(SetNode::Ref(high).index() < arg_one->index());
@@ -431,24 +650,27 @@ Zbdd::VertexPtr Zbdd::Apply<kAnd>(const SetNodePtr& arg_one,
 /// Specialization of Apply for AND operator for any ZBDD vertices.
 template <>
 Zbdd::VertexPtr Zbdd::Apply<kAnd>(const VertexPtr& arg_one,
-                                  const VertexPtr& arg_two,
-                                  int limit_order) noexcept {
+                                  const VertexPtr& arg_two, int limit_order,
+                                  int limit_weight) noexcept {
   if (limit_order < 0)
     return kEmpty_;
+  if (limit_weight < 0)
+    return Truncate(limit_weight, !IsEmpty(arg_one) && !IsEmpty(arg_two));
   if (arg_one->terminal()) {
     if (Terminal<SetNode>::Ref(arg_one).value())
-      return Prune(arg_two, limit_order);
+      return Prune(arg_two, limit_order, limit_weight);
     return kEmpty_;
   }
   if (arg_two->terminal()) {
     if (Terminal<SetNode>::Ref(arg_two).value())
-      return Prune(arg_one, limit_order);
+      return Prune(arg_one, limit_order, limit_weight);
     return kEmpty_;
   }
   if (arg_one->id() == arg_two->id())
-    return Prune(arg_one, limit_order);
+    return Prune(arg_one, limit_order, limit_weight);
 
-  VertexPtr& result = and_table_[GetResultKey(arg_one, arg_two, limit_order)];
+  VertexPtr& result =
+      and_table_[GetResultKey(arg_one, arg_two, limit_order, limit_weight)];
   if (result)
     return result;  // Already computed.
 
@@ -460,24 +682,29 @@ Zbdd::VertexPtr Zbdd::Apply<kAnd>(const VertexPtr& arg_one,
              set_one->index() < set_two->index()) {
     std::swap(set_one, set_two);
   }
-  result = Apply<kAnd>(set_one, set_two, limit_order);
+  result = Apply<kAnd>(set_one, set_two, limit_order, limit_weight);
   assert(result->terminal() ||
          SetNode::Ref(result).max_set_order() <= limit_order);
+  assert(result->terminal() ||
+         SetNode::Ref(result).max_set_weight() <= limit_weight);
   return result;
 }
 
 /// Specialization of Apply for OR operator for non-terminal ZBDD vertices.
 template <>
 Zbdd::VertexPtr Zbdd::Apply<kOr>(const SetNodePtr& arg_one,
-                                 const SetNodePtr& arg_two,
-                                 int limit_order) noexcept {
+                                 const SetNodePtr& arg_two, int limit_order,
+                                 int limit_weight) noexcept {
   VertexPtr high;
   VertexPtr low;
   int limit_high = limit_order - !MayBeUnity(*arg_one);
+  int weight_high = limit_weight - GetWeight(*arg_one);
   if (arg_one->order() == arg_two->order() &&
       arg_one->index() == arg_two->index()) {  // The same variable.
-    high = Apply<kOr>(arg_one->high(), arg_two->high(), limit_high);
-    low = Apply<kOr>(arg_one->low(), arg_two->low(), limit_order);
+    high = Apply<kOr>(arg_one->high(), arg_two->high(), limit_high,
+                      weight_high);
+    low = Apply<kOr>(arg_one->low(), arg_two->low(), limit_order,
+                     limit_weight);
   } else {
     assert((arg_one->order() < arg_two->order() ||
             arg_one->index() > arg_two->index()) &&
@@ -486,8 +713,8 @@ Zbdd::VertexPtr Zbdd::Apply<kOr>(const SetNodePtr& arg_one,
       if (arg_one->high()->terminal() && arg_two->high()->terminal())
         return kBase_;
     }
-    high = Prune(arg_one->high(), limit_high);
-    low = Apply<kOr>(arg_one->low(), arg_two, limit_order);
+    high = Prune(arg_one->high(), limit_high, weight_high);
+    low = Apply<kOr>(arg_one->low(), arg_two, limit_order, limit_weight);
   }
   if (!high->terminal() && SetNode::Ref(high).order() == arg_one->order()) {
     assert(SetNode::Ref(high).index() < arg_one->index());
@@ -499,24 +726,27 @@ Zbdd::VertexPtr Zbdd::Apply<kOr>(const SetNodePtr& arg_one,
 /// Specialization of Apply for OR operator for any ZBDD vertices.
 template <>
 Zbdd::VertexPtr Zbdd::Apply<kOr>(const VertexPtr& arg_one,
-                                 const VertexPtr& arg_two,
-                                 int limit_order) noexcept {
+                                 const VertexPtr& arg_two, int limit_order,
+                                 int limit_weight) noexcept {
   if (limit_order < 0)
     return kEmpty_;
+  if (limit_weight < 0)
+    return Truncate(limit_weight, !IsEmpty(arg_one) || !IsEmpty(arg_two));
   if (arg_one->terminal()) {
     if (Terminal<SetNode>::Ref(arg_one).value())
       return kBase_;
-    return Prune(arg_two, limit_order);
+    return Prune(arg_two, limit_order, limit_weight);
   }
   if (arg_two->terminal()) {
     if (Terminal<SetNode>::Ref(arg_two).value())
       return kBase_;
-    return Prune(arg_one, limit_order);
+    return Prune(arg_one, limit_order, limit_weight);
   }
   if (arg_one->id() == arg_two->id())
-    return Prune(arg_one, limit_order);
+    return Prune(arg_one, limit_order, limit_weight);
 
-  VertexPtr& result = or_table_[GetResultKey(arg_one, arg_two, limit_order)];
+  VertexPtr& result =
+      or_table_[GetResultKey(arg_one, arg_two, limit_order, limit_weight)];
   if (result)
     return result;  // Already computed.
 
@@ -528,19 +758,21 @@ Zbdd::VertexPtr Zbdd::Apply<kOr>(const VertexPtr& arg_one,
              set_one->index() < set_two->index()) {
     std::swap(set_one, set_two);
   }
-  result = Apply<kOr>(set_one, set_two, limit_order);
+  result = Apply<kOr>(set_one, set_two, limit_order, limit_weight);
   assert(result->terminal() ||
          SetNode::Ref(result).max_set_order() <= limit_order);
+  assert(result->terminal() ||
+         SetNode::Ref(result).max_set_weight() <= limit_weight);
   return result;
 }
 
 Zbdd::VertexPtr Zbdd::Apply(Operator type, const VertexPtr& arg_one,
-                            const VertexPtr& arg_two,
-                            int limit_order) noexcept {
+                            const VertexPtr& arg_two, int limit_order,
+                            int limit_weight) noexcept {
   if (type == kAnd)
-    return Apply<kAnd>(arg_one, arg_two, limit_order);
+    return Apply<kAnd>(arg_one, arg_two, limit_order, limit_weight);
   assert(type == kOr && "Only normalized operations in BDD.");
-  return Apply<kOr>(arg_one, arg_two, limit_order);
+  return Apply<kOr>(arg_one, arg_two, limit_order, limit_weight);
 }
 
 Zbdd::VertexPtr Zbdd::EliminateComplements(
@@ -567,7 +799,7 @@ Zbdd::VertexPtr Zbdd::EliminateComplement(const SetNodePtr& node,
   assert(low->terminal() ||
          SetNode::Ref(low).max_set_order() <= kSettings_.limit_order());
   if (node->index() < 0 && !(node->module() && !node->coherent()))
-    return Apply<kOr>(high, low, kSettings_.limit_order());
+    return Apply<kOr>(high, low, kSettings_.limit_order(), limit_weight_);
   return Minimize(GetReducedVertex(node, high, low));
 }
 
@@ -604,7 +836,7 @@ Zbdd::VertexPtr Zbdd::EliminateConstantModule(const SetNodePtr& node,
     if (module->root_->terminal()) {
       if (!Terminal<SetNode>::Ref(module->root_).value())
         return low;
-      return Apply<kOr>(high, low, kSettings_.limit_order());
+      return Apply<kOr>(high, low, kSettings_.limit_order(), limit_weight_);
     }
   }
   return Minimize(GetReducedVertex(node, high, low));
@@ -676,23 +908,30 @@ Zbdd::VertexPtr Zbdd::Subsume(const VertexPtr& high,
   return computed;
 }
 
-Zbdd::VertexPtr Zbdd::Prune(const VertexPtr& vertex, int limit_order) noexcept {
+Zbdd::VertexPtr Zbdd::Prune(const VertexPtr& vertex, int limit_order,
+                            int limit_weight) noexcept {
   if (limit_order < 0)
     return kEmpty_;
+  if (limit_weight < 0)
+    return Truncate(limit_weight, !IsEmpty(vertex));
   if (vertex->terminal())
     return vertex;
 
   SetNodePtr node = SetNode::Ptr(vertex);
-  if (node->max_set_order() <= limit_order)
+  if (node->max_set_order() <= limit_order &&
+      node->max_set_order() < SetNode::kMaxBound &&  // Not saturated.
+      node->max_set_weight() <= limit_weight)
     return node;
 
-  VertexPtr& result = prune_results_[{node->id(), limit_order}];
+  VertexPtr& result =
+      prune_results_[{node->id(), GetLimitKey(limit_order, limit_weight)}];
   if (result)
     return result;
 
   int limit_high = limit_order - !MayBeUnity(*node);
-  result = GetReducedVertex(node, Prune(node->high(), limit_high),
-                            Prune(node->low(), limit_order));
+  int weight_high = limit_weight - GetWeight(*node);
+  result = GetReducedVertex(node, Prune(node->high(), limit_high, weight_high),
+                            Prune(node->low(), limit_order, limit_weight));
   if (!result->terminal())
     SetNode::Ref(result).minimal(node->minimal());
   return result;
@@ -713,32 +952,45 @@ bool Zbdd::MayBeUnity(const SetNode& node) noexcept {
   return false;  // Positive non-gate variable.
 }
 
-int Zbdd::GatherModules(const VertexPtr& vertex, int current_order,
-                        std::map<int, std::pair<bool, int>>* modules) noexcept {
-  assert(current_order >= 0);
-  if (vertex->terminal())
-    return Terminal<SetNode>::Ref(vertex).value() ? 0 : -1;
+std::pair<int, int>
+Zbdd::GatherModules(const VertexPtr& vertex, int current_order,
+                    int current_weight,
+                    std::map<int, ModuleLimits>* modules) noexcept {
+  assert(current_order >= 0 && current_weight >= 0);
+  if (vertex->terminal()) {
+    if (Terminal<SetNode>::Ref(vertex).value())
+      return {0, 0};
+    return {-1, -1};
+  }
   SetNode& node = SetNode::Ref(vertex);
   int contribution = !MayBeUnity(node);
-  int high_order = current_order + contribution;
-  int min_high = GatherModules(node.high(), high_order, modules);
+  int weight = GetWeight(node);
+  auto [min_high, min_high_weight] = GatherModules(
+      node.high(), current_order + contribution, current_weight + weight,
+      modules);
   assert(min_high >= 0 && "No terminal Empty should be on high branch.");
   if (node.module()) {
     int module_order = kSettings_.limit_order() - min_high - current_order;
     assert(module_order >= 0 && "Improper application of a cut-off.");
+    int module_weight = limit_weight_ - min_high_weight - current_weight;
+    assert(module_weight >= 0 && "Improper application of a cut-off.");
     if (auto it = ext::find(*modules, node.index())) {
-      std::pair<bool, int>& entry = it->second;
-      assert(entry.first == node.coherent() && "Inconsistent flags.");
-      entry.second = std::max(entry.second, module_order);
+      ModuleLimits& entry = it->second;
+      assert(entry.coherent == node.coherent() && "Inconsistent flags.");
+      entry.order = std::max(entry.order, module_order);
+      entry.weight = std::max(entry.weight, module_weight);
     } else {
-      modules->insert({node.index(), {node.coherent(), module_order}});
+      modules->insert(
+          {node.index(), {node.coherent(), module_order, module_weight}});
     }
   }
-  int min_low = GatherModules(node.low(), current_order, modules);
+  auto [min_low, min_low_weight] =
+      GatherModules(node.low(), current_order, current_weight, modules);
   assert(min_low >= -1);
   if (min_low == -1)
-    return min_high + contribution;
-  return std::min(min_high + contribution, min_low);
+    return {min_high + contribution, min_high_weight + weight};
+  return {std::min(min_high + contribution, min_low),
+          std::min(min_high_weight + weight, min_low_weight)};
 }
 
 void Zbdd::ApplySubstitutions(
@@ -768,14 +1020,15 @@ void Zbdd::ApplySubstitutions(
         continue;
       new_product = Apply<kAnd>(
           new_product, FindOrAddVertex(id, kBase_, kEmpty_, std::abs(id)),
-          kSettings_.limit_order());
+          kSettings_.limit_order(), limit_weight_);
     }
     for (int id : to_add) {
       new_product = Apply<kAnd>(
           new_product, FindOrAddVertex(id, kBase_, kEmpty_, std::abs(id)),
-          kSettings_.limit_order());
+          kSettings_.limit_order(), limit_weight_);
     }
-    new_root = Apply<kOr>(new_root, new_product, kSettings_.limit_order());
+    new_root = Apply<kOr>(new_root, new_product, kSettings_.limit_order(),
+                          limit_weight_);
   }
   root_ = std::move(new_root);
   root_ = Minimize(root_);
@@ -882,9 +1135,12 @@ void Zbdd::TestStructure(const VertexPtr& vertex, bool modules) noexcept {
 
 namespace zbdd {
 
-CutSetContainer::CutSetContainer(const Settings& settings, int module_index,
-                                 int gate_index_bound) noexcept
-    : Zbdd(settings, /*coherence=*/false, module_index),
+CutSetContainer::CutSetContainer(
+    const Settings& settings, int module_index, int gate_index_bound,
+    std::shared_ptr<const ProbabilityWeights> weights,
+    int limit_weight) noexcept
+    : Zbdd(settings, /*coherence=*/false, module_index, std::move(weights),
+           limit_weight),
       gate_index_bound_(gate_index_bound) {}
 
 Zbdd::VertexPtr CutSetContainer::ConvertGate(const Gate& gate) noexcept {
@@ -906,7 +1162,8 @@ Zbdd::VertexPtr CutSetContainer::ConvertGate(const Gate& gate) noexcept {
   auto it = args.cbegin();
   VertexPtr result = *it;
   for (++it; it != args.cend(); ++it) {
-    result = Apply(gate.type(), result, *it, settings().limit_order());
+    result = Apply(gate.type(), result, *it, settings().limit_order(),
+                   limit_weight());
   }
   ClearTables();
   return result;
@@ -930,13 +1187,14 @@ Zbdd::VertexPtr CutSetContainer::ExpandGate(
          SetNode::Ref(gate_zbdd).max_set_order() <= settings().limit_order());
   assert(cut_sets->terminal() ||
          SetNode::Ref(cut_sets).max_set_order() <= settings().limit_order());
-  return Apply<kAnd>(gate_zbdd, cut_sets, settings().limit_order());
+  return Apply<kAnd>(gate_zbdd, cut_sets, settings().limit_order(),
+                     limit_weight());
 }
 
 void CutSetContainer::Merge(const VertexPtr& vertex) noexcept {
   assert(vertex->terminal() ||
          SetNode::Ref(vertex).max_set_order() <= settings().limit_order());
-  root(Apply<kOr>(root(), vertex, settings().limit_order()));
+  root(Apply<kOr>(root(), vertex, settings().limit_order(), limit_weight()));
   ClearTables();
 }
 
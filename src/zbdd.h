@@ -20,9 +20,12 @@
 
 #pragma once
 
+#include <cmath>
 #include <cstdint>
 
+#include <algorithm>
 #include <array>
+#include <limits>
 #include <map>
 #include <memory>
 #include <unordered_map>
@@ -34,7 +37,9 @@
 #include <boost/noncopyable.hpp>
 
 #include "bdd.h"
+#include "ext/parallel.h"
 #include "pdag.h"
+#include "settings.h"
 
 namespace scram::core {
 
@@ -53,14 +58,34 @@ class SetNode : public NonTerminal<SetNode> {
   /// @param[in] flag  A flag for minimized ZBDD.
   void minimal(bool flag) { minimal_ = flag; }
 
-  /// @returns The registered order of the largest set in the ZBDD.
+  /// The saturation value of the registered set order and weight.
+  /// The bounds are packed into the node
+  /// to keep the weights free without the cut-off probability.
+  static constexpr int kMaxBound = std::numeric_limits<std::int16_t>::max();
+
+  /// @returns The registered order of the largest set in the ZBDD
+  ///          saturated at kMaxBound.
   int max_set_order() const { return max_set_order_; }
 
   /// Registers the order of the largest set in the ZBDD
   /// represented by this vertex.
   ///
   /// @param[in] order  The order/size of the largest set.
-  void max_set_order(int order) { max_set_order_ = order; }
+  void max_set_order(int order) {
+    max_set_order_ = std::min(order, kMaxBound);
+  }
+
+  /// @returns The registered weight of the heaviest set in the ZBDD
+  ///          saturated at kMaxBound.
+  int max_set_weight() const { return max_set_weight_; }
+
+  /// Registers the weight of the heaviest set in the ZBDD
+  /// represented by this vertex.
+  ///
+  /// @param[in] weight  The weight of the least probable set.
+  void max_set_weight(int weight) {
+    max_set_weight_ = std::min(weight, kMaxBound);
+  }
 
   /// @returns Whatever count is stored in this node.
   std::int64_t count() const { return count_; }
@@ -82,7 +107,8 @@ class SetNode : public NonTerminal<SetNode> {
 
  private:
   bool minimal_ = false;  ///< A flag for minimized collection of sets.
-  int max_set_order_ = 0;  ///< The order of the largest set in the ZBDD.
+  std::int16_t max_set_order_ = 0;  ///< The order of the largest set.
+  std::int16_t max_set_weight_ = 0;  ///< The weight of the heaviest set.
   std::int64_t count_ = 0;  ///< The number of products, nodes, or anything.
 };
 
@@ -126,12 +152,71 @@ struct TripletHash {
 template <typename Value>
 using TripletTable = std::unordered_map<Triplet, Value, TripletHash>;
 
+/// Quantized logarithmic probabilities of literals
+/// for the probability cut-off on products in ZBDD.
+///
+/// The weight of a literal is the negative binary logarithm
+/// of its probability in the fixed-point units rounded down,
+/// and the weight of a product is the sum of the weights of its literals.
+/// Since the weights are never overestimated,
+/// the products heavier than the limit of the cut-off
+/// are guaranteed to be less probable than the cut-off.
+/// The integer weights are limited and memoized in ZBDD computations
+/// the same way as the order of products.
+class ProbabilityWeights {
+ public:
+  static constexpr int kScale = 16;  ///< The fixed-point units per bit.
+
+  /// Creates the weights for the probability cut-off of the analysis.
+  ///
+  /// @param[in] graph  The PDAG with the basic events of the variables.
+  /// @param[in] settings  The analysis settings with the cut-off.
+  ///
+  /// @returns nullptr if the probability cut-off is not requested.
+  ///
+  /// @pre The basic events have probability expressions.
+  static std::shared_ptr<const ProbabilityWeights>
+  Create(const Pdag& graph, const Settings& settings) noexcept;
+
+  /// @param[in] p_vars  Probabilities of events mapped by the variable indices.
+  /// @param[in] cut_off  The positive cut-off probability for products.
+  ProbabilityWeights(const Pdag::IndexMap<double>& p_vars,
+                     double cut_off) noexcept;
+
+  /// @returns The limit on the weight of products.
+  int limit() const { return limit_; }
+
+  /// @param[in] literal  The positive or negative index of a variable.
+  ///
+  /// @returns The weight of the literal.
+  int operator()(int literal) const {
+    return literal > 0 ? weights_[literal][0] : weights_[-literal][1];
+  }
+
+  /// @param[in] weight  The weight of a product.
+  ///
+  /// @returns The upper bound of the probability of the product.
+  static double p(int weight) { return std::exp2(-1.0 * weight / kScale); }
+
+ private:
+  int limit_;  ///< The limit on the weight of products.
+  /// The weights of the variables and their complements.
+  Pdag::IndexMap<std::array<int, 2>> weights_;
+};
+
 /// Zero-Suppressed Binary Decision Diagrams for set manipulations.
 class Zbdd : private boost::noncopyable {
  public:
   using VertexPtr = IntrusivePtr<Vertex<SetNode>>;  ///< ZBDD vertex base.
   using TerminalPtr = IntrusivePtr<Terminal<SetNode>>;  ///< Terminal vertex.
 
+  /// The module properties and the cut-offs adjusted for module products.
+  struct ModuleLimits {
+    bool coherent;  ///< The coherence of the module.
+    int order;  ///< The limit on the order of module products.
+    int weight;  ///< The limit on the weight of module products.
+  };
+
   /// Iterator over products in a ZBDD container.
   /// The implementation is complicated with the incorporation of modules.
   /// A single stack is used by all consecutive and recursive modules.
@@ -229,7 +314,13 @@ class Zbdd : private boost::noncopyable {
 
         } else {
           Push(&node);
-          return GenerateProduct(node.high()) || GenerateProduct(Pop()->low());
+          // Products of modules may exceed the limit of the cut-off together.
+          if (it_.weight_ > it_.zbdd_.limit_weight_) {
+            it_.truncated_p_ += ProbabilityWeights::p(it_.weight_);
+          } else if (GenerateProduct(node.high())) {
+            return true;
+          }
+          return GenerateProduct(Pop()->low());
         }
       }
 
@@ -241,6 +332,7 @@ class Zbdd : private boost::noncopyable {
         const SetNode* leaf = it_.node_stack_.back();
         it_.node_stack_.pop_back();
         it_.product_.pop_back();
+        it_.weight_ -= zbdd_.GetWeight(leaf->index());
         return leaf;
       }
 
@@ -250,6 +342,7 @@ class Zbdd : private boost::noncopyable {
       void Push(const SetNode* set_node) noexcept {
         it_.node_stack_.push_back(set_node);
         it_.product_.push_back(set_node->index());
+        it_.weight_ += zbdd_.GetWeight(set_node->index());
       }
 
       bool sentinel_;  ///< The signal to end the iteration.
@@ -282,6 +375,11 @@ class Zbdd : private boost::noncopyable {
       assert(*this == other && "Copy ctor is only for begin/end iterators.");
     }
 
+    /// @returns The probability upper bound of the products skipped so far
+    ///          for exceeding the probability cut-off
+    ///          with the products of several modules.
+    double truncated_probability() const { return truncated_p_; }
+
    private:
     /// Standard forward iterator functionality returning products.
     /// @{
@@ -305,6 +403,8 @@ class Zbdd : private boost::noncopyable {
     const Zbdd& zbdd_;  ///< The source container for the products.
     std::vector<int> product_;  ///< The current product.
     std::vector<const SetNode*> node_stack_;  ///< The traversal stack.
+    int weight_ = 0;  ///< The weight of the current product.
+    double truncated_p_ = 0;  ///< The bound of the skipped products.
     module_iterator it_;  ///< The root module iterator for the whole ZBDD.
   };
 
@@ -313,6 +413,8 @@ class Zbdd : private boost::noncopyable {
   ///
   /// @param[in] bdd  ROBDD with the ITE vertices.
   /// @param[in] settings  Settings for analysis.
+  /// @param[in] graph  The source PDAG of the BDD
+  ///                   for the probability cut-off if any.
   ///
   /// @pre BDD has attributed edges with only one terminal (1/True).
   ///
@@ -321,7 +423,8 @@ class Zbdd : private boost::noncopyable {
   /// @note The input BDD is not passed as a constant
   ///       because ZBDD needs BDD facilities to calculate prime implicants.
   ///       However, ZBDD guarantees to preserve the original BDD structure.
-  Zbdd(Bdd* bdd, const Settings& settings) noexcept;
+  Zbdd(Bdd* bdd, const Settings& settings,
+       const Pdag* graph = nullptr) noexcept;
 
   /// Constructor with the analysis target.
   /// ZBDD is directly produced from a PDAG.
@@ -364,14 +467,49 @@ class Zbdd : private boost::noncopyable {
   /// @returns true if the ZBDD represents a base/unity set.
   bool base() const { return root_ == kBase_; }
 
+  /// @returns The estimate of the total probability
+  ///          of the products discarded by the probability cut-off,
+  ///          i.e., the sum of the probability upper bounds
+  ///          of the partial products at the points of truncation.
+  ///
+  /// @note The products discarded in shared (memoized) computations
+  ///       are counted only once.
+  ///
+  /// @note The products of modules exceeding the cut-off together
+  ///       are skipped by the product iterators
+  ///       and are not included in this estimate.
+  double truncated_probability() const noexcept;
+
+  /// Finds the most probable products
+  /// with the best-first search over the ZBDD
+  /// guided by the upper bounds of product probabilities in sub-graphs.
+  /// Only the explored part of the ZBDD is expanded into partial products;
+  /// the full set of products is never enumerated or sorted.
+  ///
+  /// @param[in] num_products  The number of products to find.
+  /// @param[in] p_vars  Probabilities of events mapped by the variable indices.
+  ///
+  /// @returns Up to the requested number of products
+  ///          in the descending order of their probabilities.
+  ///          The products are the same as the ones visited by the iterators
+  ///          with the same order and cut-off limits.
+  std::vector<std::vector<int>>
+  FindTopProducts(int num_products,
+                  const Pdag::IndexMap<double>& p_vars) const noexcept;
+
  protected:
   /// The common constructor to initialize member variables.
   ///
   /// @param[in] settings  Settings that control analysis complexity.
   /// @param[in] coherent  A flag for coherent modular functions.
   /// @param[in] module_index  The index of a module if known.
+  /// @param[in] weights  The literal weights for the probability cut-off.
+  /// @param[in] limit_weight  The limit on the weight of products
+  ///                          (capped by the limit of the weights).
   explicit Zbdd(const Settings& settings, bool coherent = false,
-                int module_index = 0) noexcept;
+                int module_index = 0,
+                std::shared_ptr<const ProbabilityWeights> weights = nullptr,
+                int limit_weight = 0) noexcept;
 
   /// @returns Current root vertex of the ZBDD.
   const VertexPtr& root() const { return root_; }
@@ -384,6 +522,9 @@ class Zbdd : private boost::noncopyable {
   /// @returns Analysis setting with this ZBDD.
   const Settings& settings() const { return kSettings_; }
 
+  /// @returns The limit on the weight of products for computations.
+  int limit_weight() const { return limit_weight_; }
+
   /// @returns A set of registered and fully processed modules;
   const std::map<int, std::unique_ptr<Zbdd>>& modules() const {
     return modules_;
@@ -432,13 +573,14 @@ class Zbdd : private boost::noncopyable {
   /// @param[in] arg_one  First argument ZBDD set.
   /// @param[in] arg_two  Second argument ZBDD set.
   /// @param[in] limit_order  The limit on the order for the computations.
+  /// @param[in] limit_weight  The limit on the weight for the computations.
   ///
   /// @returns The resulting ZBDD vertex.
   ///
-  /// @post The limit on the set order is guaranteed.
+  /// @post The limits on the set order and weight are guaranteed.
   template <Operator Type>
   VertexPtr Apply(const VertexPtr& arg_one, const VertexPtr& arg_two,
-                  int limit_order) noexcept;
+                  int limit_order, int limit_weight) noexcept;
 
   /// Applies Boolean operation to two vertices representing sets.
   /// This is a convenience function
@@ -448,14 +590,16 @@ class Zbdd : private boost::noncopyable {
   /// @param[in] arg_one  First argument ZBDD set.
   /// @param[in] arg_two  Second argument ZBDD set.
   /// @param[in] limit_order  The limit on the order for the computations.
+  /// @param[in] limit_weight  The limit on the weight for the computations.
   ///
   /// @returns The resulting ZBDD vertex.
   ///
   /// @pre The operator is either AND or OR.
   ///
-  /// @post The limit on the set order is guaranteed.
+  /// @post The limits on the set order and weight are guaranteed.
   VertexPtr Apply(Operator type, const VertexPtr& arg_one,
-                  const VertexPtr& arg_two, int limit_order) noexcept;
+                  const VertexPtr& arg_two, int limit_order,
+                  int limit_weight) noexcept;
 
   /// Applies Boolean operation to ZBDD graph non-terminal vertices.
   ///
@@ -464,13 +608,14 @@ class Zbdd : private boost::noncopyable {
   /// @param[in] arg_one  First argument set vertex.
   /// @param[in] arg_two  Second argument set vertex.
   /// @param[in] limit_order  The limit on the order for the computations.
+  /// @param[in] limit_weight  The limit on the weight for the computations.
   ///
   /// @returns The resulting ZBDD vertex.
   ///
   /// @pre Argument vertices are ordered.
   template <Operator Type>
   VertexPtr Apply(const SetNodePtr& arg_one, const SetNodePtr& arg_two,
-                  int limit_order) noexcept;
+                  int limit_order, int limit_weight) noexcept;
 
   /// Removes complements of variables from products.
   /// This procedure only needs to be performed for non-coherent graphs
@@ -508,14 +653,16 @@ class Zbdd : private boost::noncopyable {
   ///
   /// @param[in] vertex  The root vertex to start with.
   /// @param[in] current_order  The product order from the top to the module.
-  /// @param[in,out] modules  A map of module indices, coherence, and cut-offs.
+  /// @param[in] current_weight  The product weight from the top to the module.
+  /// @param[in,out] modules  A map of module indices and limits.
   ///
-  /// @returns The minimum product order from the bottom.
-  /// @returns -1 if the vertex is terminal Empty on low branch only.
+  /// @returns The minimum product order and weight from the bottom.
+  /// @returns {-1, -1} if the vertex is terminal Empty on low branch only.
   ///
   /// @pre The ZBDD is minimal.
-  int GatherModules(const VertexPtr& vertex, int current_order,
-                    std::map<int, std::pair<bool, int>>* modules) noexcept;
+  std::pair<int, int>
+  GatherModules(const VertexPtr& vertex, int current_order, int current_weight,
+                std::map<int, ModuleLimits>* modules) noexcept;
 
   /// Applies non-declarative substitutions at the end of analysis.
   ///
@@ -523,6 +670,43 @@ class Zbdd : private boost::noncopyable {
   void ApplySubstitutions(
       const std::vector<Pdag::Substitution>& substitutions) noexcept;
 
+  /// Discards the sets over the limit of the probability cut-off
+  /// and registers their probability in the truncation estimate.
+  ///
+  /// @param[in] limit_weight  The exceeded (negative) limit on the weight.
+  /// @param[in] discard  The indication of non-empty discarded sets.
+  ///
+  /// @returns The Empty set.
+  VertexPtr Truncate(int limit_weight, bool discard = true) noexcept {
+    assert(limit_weight < 0 && weights_);
+    if (discard)
+      truncated_p_ += ProbabilityWeights::p(weights_->limit() - limit_weight);
+    return kEmpty_;
+  }
+
+  /// @param[in] vertex  A ZBDD vertex.
+  ///
+  /// @returns true if the vertex is the Empty terminal.
+  static bool IsEmpty(const VertexPtr& vertex) {
+    return vertex->terminal() && !Terminal<SetNode>::Ref(vertex).value();
+  }
+
+  /// @param[in] node  The set node of a literal.
+  ///
+  /// @returns The contribution of the literal into the weight of sets.
+  int GetWeight(const SetNode& node) noexcept {
+    if (!weights_ || MayBeUnity(node) || this->IsGate(node))
+      return 0;
+    return (*weights_)(node.index());
+  }
+
+  /// @param[in] literal  The positive or negative index of a variable.
+  ///
+  /// @returns The weight of the literal.
+  int GetWeight(int literal) const {
+    return weights_ ? (*weights_)(literal) : 0;
+  }
+
   /// Clears all memoization tables.
   void ClearTables() noexcept {
     and_table_.clear();
@@ -567,7 +751,8 @@ class Zbdd : private boost::noncopyable {
 
  private:
   using SetNodeWeakPtr = WeakIntrusivePtr<SetNode>;  ///< Pointer for tables.
-  using ComputeTable = TripletTable<VertexPtr>;  ///< General computation table.
+  /// General computation table.
+  using ComputeTable = TripletTable<VertexPtr>;
   /// Module entry in the tables with its original gate index.
   using ModuleEntry = std::pair<const int, std::unique_ptr<Zbdd>>;
 
@@ -578,6 +763,8 @@ class Zbdd : private boost::noncopyable {
   /// @param[in] coherent  A flag for coherent modular functions.
   /// @param[in] bdd  ROBDD with the ITE vertices.
   /// @param[in] settings  Settings for analysis.
+  /// @param[in] weights  The literal weights for the probability cut-off.
+  /// @param[in] limit_weight  The limit on the weight of products.
   /// @param[in] module_index  The of a module if known.
   ///
   /// @pre BDD has attributed edges with only one terminal (1/True).
@@ -588,7 +775,9 @@ class Zbdd : private boost::noncopyable {
   ///       because ZBDD needs BDD facilities to calculate prime implicants.
   ///       However, ZBDD guarantees to preserve the original BDD structure.
   Zbdd(const Bdd::Function& module, bool coherent, Bdd* bdd,
-       const Settings& settings, int module_index = 0) noexcept;
+       const Settings& settings,
+       std::shared_ptr<const ProbabilityWeights> weights, int limit_weight,
+       int module_index = 0) noexcept;
 
   /// Constructs ZBDD from modular PDAGs.
   /// This constructor does not handle constant or single variable graphs.
@@ -600,10 +789,14 @@ class Zbdd : private boost::noncopyable {
   ///
   /// @param[in] gate  The root gate of a module.
   /// @param[in] settings  Analysis settings.
+  /// @param[in] weights  The literal weights for the probability cut-off.
+  /// @param[in] limit_weight  The limit on the weight of products.
   ///
   /// @post The root vertex pointer is uninitialized
   ///       if the PDAG is constant or single variable.
-  Zbdd(const Gate& gate, const Settings& settings) noexcept;
+  Zbdd(const Gate& gate, const Settings& settings,
+       std::shared_ptr<const ProbabilityWeights> weights,
+       int limit_weight) noexcept;
 
   /// Finds a replacement for an existing node
   /// or adds a new node based on an existing node.
@@ -648,6 +841,7 @@ class Zbdd : private boost::noncopyable {
   /// @param[in] arg_one  First argument.
   /// @param[in] arg_two  Second argument.
   /// @param[in] limit_order  The limit on the order for the computations.
+  /// @param[in] limit_weight  The limit on the weight for the computations.
   ///
   /// @returns A triplet of integers for the computation key.
   ///
@@ -656,7 +850,20 @@ class Zbdd : private boost::noncopyable {
   /// @pre Even though the arguments are not SetNodePtr type,
   ///      they are ZBDD SetNode vertices.
   Triplet GetResultKey(const VertexPtr& arg_one, const VertexPtr& arg_two,
-                       int limit_order) noexcept;
+                       int limit_order, int limit_weight) noexcept;
+
+  /// Packs the limits of computations into one memoization key
+  /// that is the plain order limit without the cut-off probability.
+  ///
+  /// @param[in] limit_order  The limit on the order for the computations.
+  /// @param[in] limit_weight  The limit on the weight for the computations.
+  ///
+  /// @returns The unique key of the limits within this ZBDD.
+  int GetLimitKey(int limit_order, int limit_weight) const noexcept {
+    assert(limit_order >= 0 && limit_order <= kSettings_.limit_order());
+    assert(limit_weight >= 0 && limit_weight <= limit_weight_);
+    return limit_order + limit_weight * (kSettings_.limit_order() + 1);
+  }
 
   /// Converts BDD graph into ZBDD graph.
   ///
@@ -664,13 +871,14 @@ class Zbdd : private boost::noncopyable {
   /// @param[in] complement  Interpretation of the vertex as complement.
   /// @param[in] bdd_graph  The main ROBDD as helper database.
   /// @param[in] limit_order  The maximum size of requested sets.
-  /// @param[in,out] ites  Processed function graphs with ids and limit order.
+  /// @param[in] limit_weight  The maximum weight of requested sets.
+  /// @param[in,out] ites  Processed function graphs with ids and limits.
   ///
   /// @returns Pointer to the root vertex of the ZBDD graph.
   ///
   /// @post The input BDD structure is not changed.
   VertexPtr ConvertBdd(const Bdd::VertexPtr& vertex, bool complement,
-                       Bdd* bdd_graph, int limit_order,
+                       Bdd* bdd_graph, int limit_order, int limit_weight,
                        PairTable<VertexPtr>* ites) noexcept;
 
   /// Converts BDD if-then-else vertex into ZBDD graph.
@@ -683,11 +891,13 @@ class Zbdd : private boost::noncopyable {
   /// @param[in] complement  Interpretation of the vertex as complement.
   /// @param[in] bdd_graph  The main ROBDD as helper database.
   /// @param[in] limit_order  The maximum size of requested sets.
-  /// @param[in,out] ites  Processed function graphs with ids and limit order.
+  /// @param[in] limit_weight  The maximum weight of requested sets.
+  /// @param[in,out] ites  Processed function graphs with ids and limits.
   ///
   /// @returns Pointer to the root vertex of the ZBDD graph.
   VertexPtr ConvertBdd(const ItePtr& ite, bool complement, Bdd* bdd_graph,
-                       int limit_order, PairTable<VertexPtr>* ites) noexcept;
+                       int limit_order, int limit_weight,
+                       PairTable<VertexPtr>* ites) noexcept;
 
   /// Converts BDD if-then-else vertex into ZBDD graph for prime implicants.
   /// This is used by the BDD vertex to ZBDD converter,
@@ -697,11 +907,13 @@ class Zbdd : private boost::noncopyable {
   /// @param[in] complement  Interpretation of the vertex as complement.
   /// @param[in] bdd_graph  The main ROBDD as helper database.
   /// @param[in] limit_order  The maximum size of requested sets.
-  /// @param[in,out] ites  Processed function graphs with ids and limit order.
+  /// @param[in] limit_weight  The maximum weight of requested sets.
+  /// @param[in,out] ites  Processed function graphs with ids and limits.
   ///
   /// @returns Pointer to the root vertex of the ZBDD graph.
   VertexPtr ConvertBddPrimeImplicants(const ItePtr& ite, bool complement,
                                       Bdd* bdd_graph, int limit_order,
+                                      int limit_weight,
                                       PairTable<VertexPtr>* ites) noexcept;
 
   /// Transforms a PDAG gate into a Zbdd set graph.
@@ -768,16 +980,18 @@ class Zbdd : private boost::noncopyable {
   /// @returns Minimized high branch for a variable.
   VertexPtr Subsume(const VertexPtr& high, const VertexPtr& low) noexcept;
 
-  /// Prunes the ZBDD graph with the cut-off.
+  /// Prunes the ZBDD graph with the cut-offs.
   ///
   /// @param[in] vertex  The root vertex of the ZBDD.
   /// @param[in] limit_order  The cut-off order for the sets.
+  /// @param[in] limit_weight  The cut-off weight for the sets.
   ///
   /// @returns The root vertex of the pruned ZBDD.
   ///
   /// @post If the ZBDD is minimal,
   ///       the resultant pruned ZBDD is minimal.
-  VertexPtr Prune(const VertexPtr& vertex, int limit_order) noexcept;
+  VertexPtr Prune(const VertexPtr& vertex, int limit_order,
+                  int limit_weight) noexcept;
 
   /// Checks if a set node represents a gate.
   /// Apply operations and truncation operations
@@ -874,10 +1088,47 @@ class Zbdd : private boost::noncopyable {
 
   std::map<int, std::unique_ptr<Zbdd>> modules_;  ///< Module graphs.
   int set_id_;  ///< Identification assignment for new set graphs.
+  /// The literal weights for the probability cut-off if any.
+  std::shared_ptr<const ProbabilityWeights> weights_;
+  int limit_weight_;  ///< The limit on the weight of products (0 w/o cut-off).
+  double truncated_p_ = 0;  ///< The estimate of the truncated probability.
+  VertexPool<SetNode>::Handle pool_;  ///< The memory of the set nodes.
 };
 
 namespace zbdd {
 
+/// Analyzes independent modules concurrently
+/// on the number of jobs in the settings.
+/// Each module is analyzed with the cut-offs adjusted for its products.
+///
+/// @tparam T  The container of module products.
+/// @tparam Module  The module identifier.
+/// @tparam F  The module analysis
+///            (callable as std::unique_ptr<T>(const Module&,
+///                                            const Zbdd::ModuleLimits&,
+///                                            const Settings& adjusted)).
+///
+/// @param[in] modules  The modules with their limits.
+/// @param[in] settings  The analysis settings of the parent.
+/// @param[in] analyze  The analysis of a single module.
+///
+/// @returns The module containers in the order of the modules.
+template <class T, class Module, class F>
+std::vector<std::unique_ptr<T>> AnalyzeModules(
+    const std::vector<std::pair<Module, Zbdd::ModuleLimits>>& modules,
+    const Settings& settings, F analyze) noexcept {
+  std::vector<std::unique_ptr<T>> results(modules.size());
+  ext::parallel_for(settings.jobs(), modules.size(), [&](int i) {
+    Settings adjusted(settings);
+    adjusted.limit_order(modules[i].second.order);
+    // Nested parallelism would oversubscribe the threads of the siblings.
+    if (modules.size() > 1)
+      adjusted.jobs(1);
+    results[i] = analyze(modules[i].first, modules[i].second, adjusted);
+  });
+  return results;
+}
+
 /// Storage for generated cut sets in MOCUS.
 /// The semantics is similar to a set of cut sets.
 /// The container assumes special variable ordering.
@@ -889,6 +1140,8 @@ class CutSetContainer : public Zbdd {
   /// @param[in] settings  Settings that control analysis complexity.
   /// @param[in] module_index  The of a module if known.
   /// @param[in] gate_index_bound  The exclusive lower bound for gate indices.
+  /// @param[in] weights  The literal weights for the probability cut-off.
+  /// @param[in] limit_weight  The limit on the weight of products.
   ///
   /// @pre No complements of gates.
   /// @pre Gates are indexed sequentially
@@ -896,7 +1149,9 @@ class CutSetContainer : public Zbdd {
   /// @pre Basic events are indexed sequentially
   ///      up to a number less than or equal to the given lower bound.
   CutSetContainer(const Settings& settings, int module_index,
-                  int gate_index_bound) noexcept;
+                  int gate_index_bound,
+                  std::shared_ptr<const ProbabilityWeights> weights = nullptr,
+                  int limit_weight = 0) noexcept;
 
   /// Converts a PDAG gate into intermediate cut sets.
   ///
@@ -976,11 +1231,11 @@ class CutSetContainer : public Zbdd {
 
   /// Gathers all module indices in the cut sets.
   ///
-  /// @returns An unordered map module of indices, coherence, and cut-offs.
-  std::map<int, std::pair<bool, int>> GatherModules() noexcept {
+  /// @returns A map of module indices, coherence, and cut-offs.
+  std::map<int, ModuleLimits> GatherModules() noexcept {
     assert(Zbdd::modules().empty() && "Unexpected call with defined modules?!");
-    std::map<int, std::pair<bool, int>> modules;
-    Zbdd::GatherModules(Zbdd::root(), 0, &modules);
+    std::map<int, ModuleLimits> modules;
+    Zbdd::GatherModules(Zbdd::root(), 0, 0, &modules);
     return modules;
   }
 
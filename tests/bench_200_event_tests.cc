@@ -17,6 +17,16 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include "bdd.h"
+#include "fault_tree_analysis.h"
+#include "probability_analysis.h"
 #include "risk_analysis_tests.h"
 
 namespace scram::core::test {
@@ -35,4 +45,259 @@ TEST_P(RiskAnalysisTest, 200Event) {
   EXPECT_EQ(287, products().size());
 }
 
+TEST_P(RiskAnalysisTest, 200EventConcurrent) {
+  std::string tree_input = "input/Autogenerated/200_event.xml";
+  settings.probability_analysis(true).limit_order(15).jobs(4);
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  ASSERT_NO_THROW(analysis->Analyze());
+  if (settings.approximation() == Approximation::kRareEvent) {
+    EXPECT_NEAR(0.794828, p_total(), 1e-5);
+  } else {
+    EXPECT_NEAR(0.55985, p_total(), 1e-5);
+  }
+  EXPECT_EQ(287, products().size());
+}
+
+TEST_P(RiskAnalysisTest, 200EventReordered) {
+  std::string tree_input = "input/Autogenerated/200_event.xml";
+  settings.probability_analysis(true).limit_order(15).reorder_time(10);
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  ASSERT_NO_THROW(analysis->Analyze());
+  if (settings.approximation() == Approximation::kRareEvent) {
+    EXPECT_NEAR(0.794828, p_total(), 1e-5);
+  } else {
+    EXPECT_NEAR(0.55985, p_total(), 1e-5);
+  }
+  EXPECT_EQ(287, products().size());
+
+  auto count_vertices = [this](double reorder_time) {
+    Settings bdd_settings = settings;
+    bdd_settings.reorder_time(reorder_time);
+    FaultTreeAnalyzer<Bdd> fta(*gates().find("TopEvent")->get(), bdd_settings);
+    fta.Analyze();
+    return fta.algorithm()->CountIteNodes();
+  };
+  EXPECT_LT(count_vertices(10), count_vertices(0));
+}
+
+TEST_P(RiskAnalysisTest, 200EventVariableOrders) {
+  std::string tree_input = "input/Autogenerated/200_event.xml";
+  for (const char* order : {"force", "fan-in", "tournament"}) {
+    SCOPED_TRACE(order);
+    settings.probability_analysis(true).limit_order(15);
+    if (settings.algorithm() == Algorithm::kMocus ||
+        (settings.algorithm() == Algorithm::kZbdd &&
+         std::string(order) == "tournament")) {
+      EXPECT_THROW(settings.variable_order(order), SettingsError);
+      continue;
+    }
+    settings.variable_order(order);
+    ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+    ASSERT_NO_THROW(analysis->Analyze());
+    if (settings.approximation() == Approximation::kRareEvent) {
+      EXPECT_NEAR(0.794828, p_total(), 1e-5);
+    } else {
+      EXPECT_NEAR(0.55985, p_total(), 1e-5);
+    }
+    EXPECT_EQ(287, products().size());
+  }
+}
+
+TEST_P(RiskAnalysisTest, 200EventTopProducts) {
+  std::string tree_input = "input/Autogenerated/200_event.xml";
+  settings.probability_analysis(true).limit_order(15);
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  ASSERT_NO_THROW(analysis->Analyze());
+  std::vector<double> expected;
+  for (const auto& entry : product_probability())
+    expected.push_back(entry.second);
+  ASSERT_EQ(287, expected.size());
+  std::sort(expected.begin(), expected.end(), std::greater<>());
+
+  for (int num_products : {1, 20, 287, 1000}) {
+    SCOPED_TRACE(num_products);
+    settings.top_products(num_products);
+    ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+    ASSERT_NO_THROW(analysis->Analyze());
+    const FaultTreeAnalysis& fta =
+        *analysis->results().front().fault_tree_analysis;
+    const ProductContainer& products = fta.products();
+    ASSERT_EQ(std::min(num_products, 287), products.size());
+    EXPECT_EQ(num_products < 287,
+              fta.warnings().find("most probable") != std::string::npos);
+    auto it = expected.begin();
+    for (const Product& product : products)
+      EXPECT_DOUBLE_EQ(*it++, product.p());
+  }
+}
+
+TEST_P(RiskAnalysisTest, 200EventCutOff) {
+  std::string tree_input = "input/Autogenerated/200_event.xml";
+  settings.probability_analysis(true).limit_order(15);
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  ASSERT_NO_THROW(analysis->Analyze());
+  std::map<std::set<std::string>, double> expected = product_probability();
+  ASSERT_EQ(287, expected.size());
+
+  const double kCutOff = 1e-23;
+  settings.cut_off(kCutOff);
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  ASSERT_NO_THROW(analysis->Analyze());
+  const auto& truncated = product_probability();
+  EXPECT_EQ(120, truncated.size());
+  double p_discarded = 0;
+  for (const auto& [product, p] : expected) {
+    if (truncated.count(product)) {
+      EXPECT_GT(p, kCutOff / 2);  // The weights are rounded down.
+    } else {
+      EXPECT_LT(p, kCutOff);
+      p_discarded += p;
+    }
+  }
+  for (const auto& entry : truncated)
+    EXPECT_TRUE(expected.count(entry.first));
+  double p_estimate = analysis->results()
+                          .front()
+                          .fault_tree_analysis->products()
+                          .truncated_probability();
+  EXPECT_LT(p_discarded, p_estimate);
+  EXPECT_LT(p_estimate, 1e-18);
+
+  std::vector<double> top_expected;
+  for (const auto& entry : truncated)
+    top_expected.push_back(entry.second);
+  std::sort(top_expected.begin(), top_expected.end(), std::greater<>());
+  settings.top_products(1000);
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  ASSERT_NO_THROW(analysis->Analyze());
+  const ProductContainer& top_products =
+      analysis->results().front().fault_tree_analysis->products();
+  ASSERT_EQ(top_expected.size(), top_products.size());
+  auto it = top_expected.begin();
+  for (const Product& product : top_products)
+    EXPECT_DOUBLE_EQ(*it++, product.p());
+}
+
+namespace {
+
+/// Calculates the probability of a BDD function
+/// with the exact recursive traversal of its vertices,
+/// independent of the flat BDD calculations.
+double CalculateProbability(const Bdd& bdd, const Bdd::VertexPtr& vertex,
+                            const Pdag::IndexMap<double>& p_vars,
+                            std::unordered_map<int, double>* memo) {
+  if (vertex->terminal())
+    return 1;
+  if (auto it = memo->find(vertex->id()); it != memo->end())
+    return it->second;
+  const Ite& ite = Ite::Ref(vertex);
+  double p_var = 0;
+  if (ite.module()) {
+    const Bdd::Function& res = bdd.modules().find(ite.index())->second;
+    p_var = CalculateProbability(bdd, res.vertex, p_vars, memo);
+    if (res.complement)
+      p_var = 1 - p_var;
+  } else {
+    p_var = p_vars[ite.index()];
+  }
+  double high = CalculateProbability(bdd, ite.high(), p_vars, memo);
+  double low = CalculateProbability(bdd, ite.low(), p_vars, memo);
+  if (ite.complement_edge())
+    low = 1 - low;
+  double p = p_var * high + (1 - p_var) * low;
+  memo->emplace(vertex->id(), p);
+  return p;
+}
+
+}  // namespace
+
+// The batched calculations must match the exact recursive BDD traversal.
+TEST_F(RiskAnalysisTest, 200EventFlatBddLanes) {
+  std::string tree_input = "input/Autogenerated/200_event.xml";
+  settings.limit_order(15);
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  FaultTreeAnalyzer<Bdd> fta(*gates().find("TopEvent")->get(), settings);
+  fta.Analyze();
+  ProbabilityAnalyzer<Bdd> pa(&fta, &model->mission_time());
+  pa.Analyze();
+
+  const int kNumLanes = 8;
+  Pdag::IndexMap<double> p_vars = pa.p_vars();
+  int num_vars = p_vars.size();
+  std::vector<double> batch(num_vars * kNumLanes);
+  std::vector<double> expected(kNumLanes);
+  for (int lane = 0; lane < kNumLanes; ++lane) {
+    for (int i = 0; i < num_vars; ++i) {
+      double p = pa.p_vars().data()[i] * (lane + 1) / kNumLanes;
+      p_vars.data()[i] = p;
+      batch[i * kNumLanes + lane] = p;
+    }
+    std::unordered_map<int, double> memo;
+    const Bdd::Function& root = fta.algorithm()->root();
+    double p = CalculateProbability(*fta.algorithm(), root.vertex, p_vars,
+                                    &memo);
+    expected[lane] = root.complement ? 1 - p : p;
+  }
+  std::vector<double> values;
+  std::vector<double> results(kNumLanes);
+  pa.flat_bdd().Calculate(batch.data(), kNumLanes, &values, results.data());
+  for (int lane = 0; lane < kNumLanes; ++lane)
+    EXPECT_NEAR(expected[lane], results[lane], 1e-12) << lane;
+  EXPECT_NEAR(0.55985, results.back(), 1e-5);  // The reference value.
+}
+
+// The calculations with the compiled products must match the products.
+TEST_F(RiskAnalysisTest, 200EventFlatProducts) {
+  std::string tree_input = "input/Autogenerated/200_event.xml";
+  settings.limit_order(15);
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  FaultTreeAnalyzer<Bdd> fta(*gates().find("TopEvent")->get(), settings);
+  fta.Analyze();
+  const ProductContainer& products = fta.products();
+  FlatProducts flat_products(products.zbdd());
+  ASSERT_EQ(287, flat_products.size());
+  ASSERT_EQ(products.size(), flat_products.size());
+
+  double p_rare_event = 0;
+  double p_mcub_complement = 1;
+  for (const Product& product : products) {
+    p_rare_event += product.p();
+    p_mcub_complement *= 1 - product.p();
+  }
+  EXPECT_NEAR(0.794828, p_rare_event, 1e-5);
+  Pdag::IndexMap<double> p_vars;
+  for (const mef::BasicEvent* event : fta.graph()->basic_events())
+    p_vars.push_back(event->p());
+  EXPECT_NEAR(p_rare_event,
+              RareEventCalculator().Calculate(flat_products, p_vars), 1e-12);
+  EXPECT_NEAR(1 - p_mcub_complement,
+              McubCalculator().Calculate(flat_products, p_vars), 1e-12);
+
+  const int kNumLanes = 3;
+  std::vector<double> batch(p_vars.size() * kNumLanes);
+  std::vector<double> rare_event(kNumLanes);
+  std::vector<double> mcub(kNumLanes);
+  for (int lane = 0; lane < kNumLanes; ++lane) {
+    Pdag::IndexMap<double> lane_p_vars = p_vars;
+    for (int i = 0; i < p_vars.size(); ++i) {
+      lane_p_vars.data()[i] *= 1.0 / (lane + 1);
+      batch[i * kNumLanes + lane] = lane_p_vars.data()[i];
+    }
+    rare_event[lane] =
+        RareEventCalculator().Calculate(flat_products, lane_p_vars);
+    mcub[lane] = McubCalculator().Calculate(flat_products, lane_p_vars);
+  }
+  std::vector<double> results(kNumLanes);
+  RareEventCalculator().Calculate(flat_products, batch.data(), kNumLanes,
+                                  results.data());
+  for (int lane = 0; lane < kNumLanes; ++lane)
+    EXPECT_DOUBLE_EQ(rare_event[lane], results[lane]) << lane;
+  EXPECT_NEAR(0.794828, results.front(), 1e-5);  // The reference value.
+  McubCalculator().Calculate(flat_products, batch.data(), kNumLanes,
+                             results.data());
+  for (int lane = 0; lane < kNumLanes; ++lane)
+    EXPECT_DOUBLE_EQ(mcub[lane], results[lane]) << lane;
+  EXPECT_NEAR(1 - p_mcub_complement, results.front(), 1e-12);
+}
+
 }  // namespace scram::core::test
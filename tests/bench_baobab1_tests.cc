@@ -17,6 +17,8 @@
 
 #include <gtest/gtest.h>
 
+#include <unordered_set>
+
 #include "risk_analysis_tests.h"
 
 namespace scram::core::test {
@@ -55,6 +57,33 @@ TEST_P(RiskAnalysisTest, Baobab1L8) {
   EXPECT_EQ(distr, ProductDistribution());
 }
 
+// The one-pass product summary must match the reference and a full walk.
+TEST_P(RiskAnalysisTest, Baobab1L8ProductSummary) {
+  std::vector<std::string> input_files = {
+      "input/Baobab/baobab1.xml", "input/Baobab/baobab1-basic-events.xml"};
+  settings.limit_order(8);
+  ASSERT_NO_THROW(ProcessInputFiles(input_files));
+  ASSERT_NO_THROW(analysis->Analyze());
+  const ProductContainer& products =
+      analysis->results().front().fault_tree_analysis->products();
+  int size = 0;
+  std::vector<int> distr;
+  std::unordered_set<const mef::BasicEvent*> events;
+  for (const Product& product : products) {
+    ++size;
+    if (distr.size() < product.order())
+      distr.resize(product.order());
+    ++distr[product.order() - 1];
+    for (const Literal& literal : product)
+      events.insert(&literal.event);
+  }
+  EXPECT_EQ(25892, size);
+  EXPECT_EQ(std::vector<int>({0, 1, 1, 70, 400, 2212, 14748, 8460}), distr);
+  EXPECT_EQ(size, products.size());
+  EXPECT_EQ(distr, products.Distribution());
+  EXPECT_EQ(events, products.product_events());
+}
+
 TEST_P(RiskAnalysisTest, Baobab1L4Importance) {
   std::vector<std::string> input_files = {
       "input/Baobab/baobab1.xml", "input/Baobab/baobab1-basic-events.xml"};
@@ -71,4 +100,40 @@ TEST_P(RiskAnalysisTest, Baobab1L4Importance) {
       40, analysis->results().front().importance_analysis->importance().size());
 }
 
+// The reordering of module BDD variables must not change the results.
+TEST_F(RiskAnalysisTest, Baobab1L6Reordered) {
+  std::vector<std::string> input_files = {
+      "input/Baobab/baobab1.xml", "input/Baobab/baobab1-basic-events.xml"};
+  settings.limit_order(6).probability_analysis(true).reorder_time(1);
+  ASSERT_NO_THROW(ProcessInputFiles(input_files));
+  ASSERT_NO_THROW(analysis->Analyze());
+  EXPECT_NEAR(1.2823e-6, p_total(), 1e-8);
+  EXPECT_EQ(2684, products().size());
+  std::vector<int> distr = {0, 1, 1, 70, 400, 2212};
+  EXPECT_EQ(distr, ProductDistribution());
+}
+
+// The concurrent analysis of sibling modules must not change the results.
+TEST_P(RiskAnalysisTest, Baobab1L6ConcurrentModules) {
+  std::vector<std::string> input_files = {
+      "input/Baobab/baobab1.xml", "input/Baobab/baobab1-basic-events.xml"};
+  settings.limit_order(6).probability_analysis(true);
+  ASSERT_NO_THROW(ProcessInputFiles(input_files));
+  ASSERT_NO_THROW(analysis->Analyze());
+  std::set<std::set<std::string>> serial_products = products();
+  double serial_p_total = p_total();
+  EXPECT_EQ(2684, serial_products.size());
+
+  settings.jobs(4);
+  ASSERT_NO_THROW(ProcessInputFiles(input_files));
+  ASSERT_NO_THROW(analysis->Analyze());
+  EXPECT_EQ(serial_products, products());
+  EXPECT_EQ(serial_p_total, p_total());
+  std::vector<int> distr = {0, 1, 1, 70, 400, 2212};
+  EXPECT_EQ(distr, ProductDistribution());
+  if (settings.approximation() == Approximation::kNone) {
+    EXPECT_NEAR(1.2823e-6, p_total(), 1e-8);  // The cut-off doesn't apply.
+  }
+}
+
 }  // namespace scram::core::test
@@ -15,6 +15,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <cmath>
+
 #include <gtest/gtest.h>
 
 #include "risk_analysis_tests.h"
@@ -96,6 +98,26 @@ TEST_P(RiskAnalysisTest, Vote) {
   EXPECT_EQ(mcs, products());
 }
 
+// Wide K/N gate with 10/20 combinations of identical events.
+// The products are not generated due to the limit order.
+TEST_P(RiskAnalysisTest, VoteWide) {
+  std::string tree_input = "tests/input/core/atleast_wide.xml";
+  settings.probability_analysis(true).limit_order(9);
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  ASSERT_NO_THROW(analysis->Analyze());
+  EXPECT_TRUE(products().empty());
+  if (settings.algorithm() == Algorithm::kBdd) {  // The exact binomial tail.
+    double p_tail = 0;
+    double binomial = 1;  // C(20, i).
+    for (int i = 0; i <= 20; ++i) {
+      if (i >= 10)
+        p_tail += binomial * std::pow(0.1, i) * std::pow(0.9, 20 - i);
+      binomial = binomial * (20 - i) / (i + 1);
+    }
+    EXPECT_NEAR(p_tail, p_total(), 1e-12 * p_tail);
+  }
+}
+
 // Benchmark tests for NOT gate.
 // [A OR NOT A]
 // This produces UNITY top gate.
@@ -17,25 +17,105 @@
 
 #include <gtest/gtest.h>
 
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "risk_analysis_tests.h"
 
 namespace scram::core::test {
 
+namespace {
+
+/// The reference probabilities of the reactive gas leak sequences.
+const std::map<std::string, double> kGasLeakReactiveSequences = {
+    {"S1", 0.81044}, {"S2", 0.04479}, {"S3", 0.04265}, {"S4", 2.36e-3},
+    {"S5", 0.04265}, {"S6", 2.36e-3}, {"S7", 4.5e-3},  {"S8", 0.05025}};
+
+/// Checks the sequence probabilities against the reference values.
+void CheckGasLeakReactiveSequences(
+    const std::map<std::string, double>& results) {
+  ASSERT_EQ(kGasLeakReactiveSequences.size(), results.size());
+  for (const auto& entry : kGasLeakReactiveSequences) {
+    ASSERT_TRUE(results.count(entry.first)) << entry.first;
+    EXPECT_NEAR(entry.second, results.at(entry.first), 1e-5) << entry.first;
+  }
+}
+
+}  // namespace
+
 TEST_F(RiskAnalysisTest, GasLeakReactive) {
   const char* tree_input = "input/EventTrees/gas_leak/gas_leak_reactive.xml";
   settings.probability_analysis(true);
   ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
   ASSERT_NO_THROW(analysis->Analyze());
   EXPECT_EQ(1, analysis->event_tree_results().size());
-  std::map<std::string, double> expected = {
-      {"S1", 0.81044}, {"S2", 0.04479}, {"S3", 0.04265}, {"S4", 2.36e-3},
-      {"S5", 0.04265}, {"S6", 2.36e-3}, {"S7", 4.5e-3},  {"S8", 0.05025}};
-  const auto& results = sequences();
-  ASSERT_EQ(8, results.size());
-  for (const auto& result : expected) {
-    ASSERT_TRUE(results.count(result.first)) << result.first;
-    EXPECT_NEAR(result.second, results.at(result.first), 1e-5) << result.first;
+  CheckGasLeakReactiveSequences(sequences());
+}
+
+TEST_F(RiskAnalysisTest, GasLeakReactiveConcurrent) {
+  const char* tree_input = "input/EventTrees/gas_leak/gas_leak_reactive.xml";
+  settings.probability_analysis(true).importance_analysis(true);
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  ASSERT_NO_THROW(analysis->Analyze());
+  // The results are in the order of the sequences in the event tree.
+  std::vector<std::pair<std::string, double>> expected;
+  for (const RiskAnalysis::Result& result : analysis->results()) {
+    ASSERT_TRUE(result.probability_analysis);
+    expected.emplace_back(GetTargetName(result),
+                          result.probability_analysis->p_total());
+  }
+
+  settings.jobs(4);
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  ASSERT_NO_THROW(analysis->Analyze());
+  ASSERT_EQ(expected.size(), analysis->results().size());
+  for (int i = 0; i < expected.size(); ++i) {
+    const RiskAnalysis::Result& result = analysis->results()[i];
+    std::string id = GetTargetName(result);
+    ASSERT_EQ(expected[i].first, id);
+    ASSERT_TRUE(result.probability_analysis) << id;
+    EXPECT_EQ(expected[i].second, result.probability_analysis->p_total())
+        << id;
+  }
+  CheckGasLeakReactiveSequences(sequences());
+}
+
+TEST_F(RiskAnalysisTest, GasLeakReactiveShared) {
+  const char* tree_input = "input/EventTrees/gas_leak/gas_leak_reactive.xml";
+  settings.probability_analysis(true).importance_analysis(true);
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  ASSERT_NO_THROW(analysis->Analyze());
+  std::map<std::string, std::pair<double, int>> expected;
+  for (const RiskAnalysis::Result& result : analysis->results()) {
+    ASSERT_TRUE(result.probability_analysis);
+    int num_products = result.fault_tree_analysis
+                           ? result.fault_tree_analysis->products().size()
+                           : -1;
+    expected.emplace(GetTargetName(result),
+                     std::pair(result.probability_analysis->p_total(),
+                               num_products));
+  }
+
+  settings.shared_sequences(true);
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  ASSERT_NO_THROW(analysis->Analyze());
+  ASSERT_EQ(expected.size(), analysis->results().size());
+  for (const RiskAnalysis::Result& result : analysis->results()) {
+    std::string name = GetTargetName(result);
+    ASSERT_TRUE(expected.count(name)) << name;
+    ASSERT_TRUE(result.probability_analysis) << name;
+    EXPECT_NEAR(expected.at(name).first,
+                result.probability_analysis->p_total(), 1e-12)
+        << name;
+    if (result.fault_tree_analysis) {
+      EXPECT_EQ(expected.at(name).second,
+                result.fault_tree_analysis->products().size())
+          << name;
+    }
   }
+  CheckGasLeakReactiveSequences(sequences());
 }
 
 /// @todo Expand
@@ -43,4 +43,42 @@ TEST_P(RiskAnalysisTest, SmallTree) {
   }
 }
 
+// The seeded sampling must not depend on the number of threads.
+TEST_P(RiskAnalysisTest, SmallTreeConcurrentSampling) {
+  std::string tree_input = "input/SmallTree/SmallTree.xml";
+  settings.uncertainty_analysis(true).num_trials(10000).seed(42);
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  ASSERT_NO_THROW(analysis->Analyze());
+  double serial_mean = mean();
+  double serial_sigma = sigma();
+
+  settings.jobs(3);
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  ASSERT_NO_THROW(analysis->Analyze());
+  EXPECT_DOUBLE_EQ(serial_mean, mean());
+  EXPECT_DOUBLE_EQ(serial_sigma, sigma());
+  // The concurrent sampling must still converge to the reference values.
+  if (settings.approximation() == Approximation::kRareEvent) {
+    EXPECT_NEAR(0.0255, mean(), 1e-3);
+    EXPECT_NEAR(0.0225, sigma(), 2e-3);
+  } else {
+    EXPECT_NEAR(0.0253, mean(), 1e-3);
+    EXPECT_NEAR(0.022, sigma(), 2e-3);
+  }
+}
+
+// The targets draw from their own random number streams.
+TEST_F(RiskAnalysisTest, UncertaintyTargetStreams) {
+  std::string tree_input = "tests/input/core/twin_uncertain_tops.xml";
+  settings.uncertainty_analysis(true).num_trials(1000).seed(42);
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  ASSERT_NO_THROW(analysis->Analyze());
+  ASSERT_EQ(2, analysis->results().size());
+  const auto& first = *analysis->results().front().uncertainty_analysis;
+  const auto& second = *analysis->results().back().uncertainty_analysis;
+  EXPECT_NE(first.mean(), second.mean());
+  EXPECT_NEAR(0.2775, first.mean(), 5e-3);  // 1 - (1 - 0.15)^2
+  EXPECT_NEAR(0.2775, second.mean(), 5e-3);
+}
+
 }  // namespace scram::core::test
@@ -18,6 +18,7 @@
 #include <gtest/gtest.h>
 
 #include "risk_analysis_tests.h"
+#include "utility.h"
 
 namespace scram::core::test {
 
@@ -92,4 +93,29 @@ TEST_F(RiskAnalysisTest, ThreeMotorEventTree) {
   }
 }
 
+// The sequences analyzed with the cached PDAGs.
+TEST_F(RiskAnalysisTest, ThreeMotorEventTreeCached) {
+  std::string dir = "input/ThreeMotor/";
+  fs::path cache_dir = utility::GenerateFilePath();
+  settings.probability_analysis(true).cache_dir(cache_dir.string());
+  std::map<std::string, double> expected = {
+      {"S1", 0.02115}, {"S2", 0.00272}, {"S3", 0.00309}, {"S4", 0.00272},
+      {"S5", 0.00272}, {"S6", 0.00272}, {"S7", 0.00272}, {"S8", 0.00272}};
+  for (int run = 0; run < 2; ++run) {  // Store and load.
+    SCOPED_TRACE(run);
+    ASSERT_NO_THROW(
+        ProcessInputFiles({dir + "three_motor.xml", dir + "event_tree.xml"}));
+    ASSERT_NO_THROW(analysis->Analyze());
+    const auto& results = sequences();
+    ASSERT_EQ(8, results.size());
+    for (const auto& result : expected) {
+      ASSERT_TRUE(results.count(result.first)) << result.first;
+      EXPECT_NEAR(result.second, results.at(result.first), 1e-5)
+          << result.first;
+    }
+  }
+  EXPECT_FALSE(fs::is_empty(cache_dir));
+  fs::remove_all(cache_dir);
+}
+
 }  // namespace scram::core::test
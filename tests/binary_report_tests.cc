@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2018 Olzhas Rakhimov
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "binary_report.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "utility.h"
+
+#include "error.h"
+#include "initializer.h"
+#include "settings.h"
+
+namespace scram::test {
+
+namespace {
+
+/// The products as sets of literal names mapped to their probabilities.
+using ProductMap = std::map<std::set<std::string>, double>;
+
+/// @returns The products of the analysis result.
+ProductMap Extract(const core::RiskAnalysis::Result& result) {
+  ProductMap products;
+  for (const core::Product& product : result.fault_tree_analysis->products()) {
+    std::set<std::string> names;
+    for (const core::Literal& literal : product)
+      names.insert((literal.complement ? "not " : "") + literal.event.id());
+    products.emplace(std::move(names),
+                     result.probability_analysis ? product.p() : 0);
+  }
+  return products;
+}
+
+/// @returns The products of the binary report result.
+ProductMap Extract(const BinaryReport& report,
+                   const BinaryReport::Result& result) {
+  ProductMap products;
+  std::vector<BinaryReport::Literal> literals;
+  int prev_order = -1;
+  for (int i = 0; i < result.num_groups(); ++i) {
+    BinaryReport::Group group = result.group(i);
+    EXPECT_LT(prev_order, group.order());
+    prev_order = group.order();
+    for (std::size_t j = 0; j < group.size(); ++j) {
+      group.product(j, &literals);
+      std::set<std::string> names;
+      for (const BinaryReport::Literal& literal : literals) {
+        names.insert((literal.complement ? "not " : "") +
+                     std::string(report.event(literal.event)));
+      }
+      products.emplace(std::move(names),
+                       group.has_probabilities() ? group.probability(j) : 0);
+    }
+  }
+  return products;
+}
+
+}  // namespace
+
+TEST(BinaryReportTest, RoundTrip) {
+  std::vector<std::vector<std::string>> inputs = {
+      {"tests/input/fta/correct_tree_input_with_probs.xml"},
+      {"input/TwoTrain/two_train.xml", "input/TwoTrain/event_tree.xml"},
+      {"input/EventTrees/attack.xml"},
+      {"input/Baobab/baobab2.xml", "input/Baobab/baobab2-basic-events.xml"}};
+  for (bool probability : {false, true}) {
+    core::Settings settings;
+    settings.probability_analysis(probability);
+    for (const auto& input : inputs) {
+      std::shared_ptr<mef::Model> model;
+      ASSERT_NO_THROW(model = mef::Initializer(input, settings).model());
+      core::RiskAnalysis analysis(model.get(), settings);
+      analysis.Analyze();
+      fs::path temp_file = utility::GenerateFilePath();
+      ASSERT_NO_THROW(BinaryReporter().Report(analysis, temp_file.string()))
+          << input.front() << " => " << temp_file;
+
+      // Only the results with products are reported.
+      std::vector<const core::RiskAnalysis::Result*> results;
+      for (const core::RiskAnalysis::Result& result : analysis.results()) {
+        if (result.fault_tree_analysis)
+          results.push_back(&result);
+      }
+      BinaryReport report(temp_file.string());
+      ASSERT_EQ(results.size(), report.num_results()) << input.front();
+      for (int i = 0; i < report.num_results(); ++i) {
+        const core::RiskAnalysis::Result& result = *results[i];
+        BinaryReport::Result view = report.result(i);
+        if (const mef::Gate* const* gate =
+                std::get_if<const mef::Gate*>(&result.id.target)) {
+          EXPECT_EQ((*gate)->id(), view.name());
+          EXPECT_TRUE(view.initiating_event().empty());
+        } else {
+          const auto& sequence = std::get<1>(result.id.target);
+          EXPECT_EQ(sequence.second.name(), view.name());
+          EXPECT_EQ(sequence.first.name(), view.initiating_event());
+        }
+        if (probability) {
+          EXPECT_EQ(result.probability_analysis->p_total(),
+                    view.probability());
+        } else {
+          EXPECT_TRUE(std::isnan(view.probability()));
+        }
+        EXPECT_EQ(result.fault_tree_analysis->products().size(),
+                  view.num_products());
+        EXPECT_EQ(Extract(result), Extract(report, view)) << input.front();
+      }
+      fs::remove(temp_file);
+    }
+  }
+}
+
+TEST(BinaryReportTest, CorruptedFile) {
+  core::Settings settings;
+  std::shared_ptr<mef::Model> model;
+  ASSERT_NO_THROW(
+      model = mef::Initializer(
+                  {"tests/input/fta/correct_tree_input_with_probs.xml"},
+                  settings)
+                  .model());
+  core::RiskAnalysis analysis(model.get(), settings);
+  analysis.Analyze();
+  fs::path temp_file = utility::GenerateFilePath();
+  ASSERT_NO_THROW(BinaryReporter().Report(analysis, temp_file.string()));
+  std::string contents;
+  {
+    std::ifstream in(temp_file.string(), std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(in), {});
+  }
+  ASSERT_NO_THROW(BinaryReport(temp_file.string()));
+
+  auto write = [&temp_file](const std::string& bytes) {
+    std::ofstream out(temp_file.string(),
+                      std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), bytes.size());
+  };
+  // The truncated file.
+  write(contents.substr(0, contents.size() / 2));
+  EXPECT_THROW(BinaryReport(temp_file.string()), IOError);
+
+  // The literal refers to an event outside the dictionary.
+  binary::Header header;
+  std::memcpy(&header, contents.data(), sizeof(header));
+  ASSERT_LT(0, header.num_results);
+  binary::ResultEntry entry;
+  std::memcpy(&entry, contents.data() + header.results_offset, sizeof(entry));
+  ASSERT_LT(0, entry.num_orders);
+  binary::OrderEntry group;
+  std::memcpy(&group, contents.data() + entry.orders_offset, sizeof(group));
+  ASSERT_LT(0, group.order * group.num_products);
+  std::uint32_t code = header.num_events << 1;
+  std::string corrupted = contents;
+  std::memcpy(corrupted.data() + group.literals_offset, &code, sizeof(code));
+  write(corrupted);
+  BinaryReport report(temp_file.string());  // Literals are checked lazily.
+  std::vector<BinaryReport::Literal> literals;
+  EXPECT_THROW(report.result(0).group(0).product(0, &literals), IOError);
+  fs::remove(temp_file);
+}
+
+TEST(BinaryReportTest, InvalidFile) {
+  EXPECT_THROW(BinaryReport("nonexistent_binary_report.bin"), IOError);
+  EXPECT_THROW(BinaryReport("tests/input/fta/correct_tree_input.xml"),
+               IOError);
+}
+
+}  // namespace scram::test
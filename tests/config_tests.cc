@@ -66,10 +66,12 @@ TEST(ConfigTest, FullSettings) {
   EXPECT_TRUE(settings.ccf_analysis());
   EXPECT_TRUE(settings.safety_integrity_levels());
   EXPECT_EQ(core::Approximation::kRareEvent, settings.approximation());
+  EXPECT_EQ(core::VariableOrder::kForce, settings.variable_order());
   EXPECT_EQ(11, settings.limit_order());
   EXPECT_EQ(48, settings.mission_time());
   EXPECT_EQ(1, settings.time_step());
   EXPECT_EQ(0.009, settings.cut_off());
+  EXPECT_EQ(100, settings.top_products());
   EXPECT_EQ(777, settings.num_trials());
   EXPECT_EQ(13, settings.num_quantiles());
   EXPECT_EQ(31, settings.num_bins());
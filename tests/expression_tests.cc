@@ -16,6 +16,7 @@
  */
 
 #include "expression.h"
+#include "expression_program.h"
 #include "expression/boolean.h"
 #include "expression/conditional.h"
 #include "expression/constant.h"
@@ -1182,4 +1183,54 @@ TEST(ExpressionTest, Switch) {
   EXPECT_DOUBLE_EQ(10, Switch({}, &arg_three).value());
 }
 
+// The compiled program must evaluate the same values as the expressions.
+TEST(ExpressionTest, Program) {
+  MissionTime time(100);
+  ConstantExpression lambda(1e-3);
+  ConstantExpression gamma(0.1);
+  ConstantExpression mu(1e-2);
+  ConstantExpression alpha(500);
+  ConstantExpression beta(1.5);
+  ConstantExpression t0(50);
+  ConstantExpression threshold(300);
+  ConstantExpression fixed_time(200);
+  Parameter rate("rate");
+  rate.expression(&lambda);
+  Parameter current_time("current_time");
+  current_time.expression(&time);
+
+  Exponential exponential(&rate, &current_time);
+  Glm glm(&gamma, &rate, &mu, &time);
+  Weibull weibull(&alpha, &beta, &t0, &time);
+  Exponential fixed(&rate, &fixed_time);
+  Add sum({&exponential, &glm, &fixed});
+  Mean mean({&sum, &weibull});
+  Lt early(&time, &threshold);
+  Ite conditional(&early, &exponential, &weibull);  // The tree fallback.
+  Mul product({&conditional, &mean});
+
+  ExpressionProgram program(&time);
+  EXPECT_FALSE(program.IsDynamic(&fixed));
+  EXPECT_TRUE(program.IsDynamic(&product));
+  std::vector<Expression*> outputs = {&fixed,   &exponential, &glm,
+                                      &weibull, &mean,        &conditional,
+                                      &product, &time};
+  for (Expression* output : outputs)
+    program.AddOutput(output);
+  ASSERT_EQ(outputs.size(), program.num_outputs());
+
+  std::vector<double> times = {0, 10, 250, 300, 700, 1000};
+  int num_lanes = times.size();
+  std::vector<double> results(outputs.size() * num_lanes);
+  program.Evaluate(times.data(), num_lanes, results.data());
+  EXPECT_EQ(100, time.value());
+  for (int j = 0; j < num_lanes; ++j) {
+    time.value(times[j]);
+    for (int i = 0; i < outputs.size(); ++i) {
+      EXPECT_DOUBLE_EQ(outputs[i]->value(), results[i * num_lanes + j])
+          << "Output " << i << " at time " << times[j];
+    }
+  }
+}
+
 }  // namespace scram::mef::test
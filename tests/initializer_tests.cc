@@ -65,6 +65,50 @@ TEST(InitializerTest, FailSchemaValidation) {
                xml::ValidityError);
 }
 
+// Concurrent parsing must not change the model or the reported error.
+TEST(InitializerTest, ConcurrentParsing) {
+  std::vector<std::string> input_files = {
+      "input/Baobab/baobab2.xml", "input/Baobab/baobab2-basic-events.xml",
+      "input/TwoTrain/two_train.xml", "input/TwoTrain/event_tree.xml"};
+  core::Settings settings;
+  std::shared_ptr<Model> expected;
+  ASSERT_NO_THROW(expected = Initializer(input_files, settings).model());
+  settings.jobs(4);
+  std::shared_ptr<Model> model;
+  ASSERT_NO_THROW(model = Initializer(input_files, settings).model());
+  EXPECT_EQ(expected->fault_trees().size(), model->fault_trees().size());
+  EXPECT_EQ(expected->gates().size(), model->gates().size());
+  EXPECT_EQ(expected->basic_events().size(), model->basic_events().size());
+  EXPECT_EQ(expected->parameters().size(), model->parameters().size());
+
+  // The first failure in the input order is reported.
+  std::string correct = "tests/input/fta/correct_tree_input.xml";
+  std::string invalid = "tests/input/schema_fail.xml";
+  std::string malformed = "tests/input/xml_formatting_error.xml";
+  EXPECT_THROW(Initializer({correct, invalid, malformed}, settings),
+               xml::ValidityError);
+  EXPECT_THROW(Initializer({correct, malformed, invalid}, settings),
+               xml::ParseError);
+}
+
+// Trusted valid input must produce the same model without validation.
+TEST(InitializerTest, TrustedInput) {
+  std::vector<std::string> input_files = {
+      "input/TwoTrain/two_train.xml", "input/TwoTrain/event_tree.xml",
+      "tests/input/fta/correct_formulas.xml"};
+  core::Settings settings;
+  std::shared_ptr<Model> expected;
+  ASSERT_NO_THROW(expected = Initializer(input_files, settings).model());
+  std::shared_ptr<Model> model;
+  ASSERT_NO_THROW(model = Initializer(input_files, settings, false, true)
+                              .model());
+  EXPECT_EQ(expected->event_trees().size(), model->event_trees().size());
+  EXPECT_EQ(expected->sequences().size(), model->sequences().size());
+  EXPECT_EQ(expected->gates().size(), model->gates().size());
+  EXPECT_EQ(expected->basic_events().size(), model->basic_events().size());
+  EXPECT_EQ(expected->house_events().size(), model->house_events().size());
+}
+
 // Unsupported operations.
 TEST(InitializerTest, UnsupportedFeature) {
   std::string dir = "tests/input/";
@@ -106,6 +106,34 @@ TEST_F(GateTest, AddArgDeathTests) {
 }
 #endif
 
+TEST_F(GateTest, ShareAndEraseArgs) {
+  DefineGate(kAnd, 4);
+  auto sub_gate = std::make_shared<Gate>(kOr, &g->graph());
+  sub_gate->AddArg(var_one);
+  sub_gate->AddArg(var_two);
+  g->AddArg(sub_gate);
+  std::vector<int> indices = {var_two->index(), var_three->index(),
+                              sub_gate->index()};
+  auto recipient = std::make_shared<Gate>(kAnd, &g->graph());
+  g->ShareArgs(indices, recipient);
+  EXPECT_EQ(indices.size(), recipient->args().size());
+  EXPECT_EQ(2, recipient->args<Variable>().size());
+  EXPECT_EQ(1, recipient->args<Gate>().size());
+  EXPECT_EQ(3, var_two->parents().size());
+  EXPECT_EQ(2, sub_gate->parents().size());
+
+  g->EraseArgs(indices);
+  EXPECT_EQ(2, g->args().size());
+  EXPECT_EQ(2, g->args<Variable>().size());
+  EXPECT_TRUE(g->args<Gate>().empty());
+  EXPECT_EQ(1, g->args().count(var_one->index()));
+  EXPECT_EQ(0, g->args().count(var_three->index()));
+  EXPECT_EQ(2, var_two->parents().size());
+  EXPECT_EQ(2, var_one->parents().size());
+  EXPECT_EQ(1, sub_gate->parents().size());
+  EXPECT_EQ(recipient->index(), sub_gate->parents().begin()->first);
+}
+
 /// Collection of tests
 /// for addition of an existing argument to a gate.
 ///
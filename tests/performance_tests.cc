@@ -43,6 +43,8 @@
 
 #include "performance_tests.h"
 
+#include <vector>
+
 #include "bdd.h"
 #include "zbdd.h"
 
@@ -58,11 +60,44 @@ TEST(RegressionTest, ObjectSize) {
   EXPECT_EQ(8, sizeof(IntrusivePtr<Vertex<Ite>>));
   EXPECT_EQ(16, sizeof(Vertex<Ite>));
   EXPECT_EQ(48, sizeof(NonTerminal<Ite>));
-  EXPECT_EQ(64, sizeof(Ite));
+  EXPECT_EQ(48, sizeof(Ite));
   EXPECT_EQ(56, sizeof(SetNode));
 }
 #endif
 
+// The memory of deleted vertices is reused before new slabs.
+TEST(VertexPoolTest, Reuse) {
+  auto pool = VertexPool<Ite>::Create();
+  IntrusivePtr<Vertex<Ite>> one(new Terminal<Ite>(true));
+  ItePtr first(new (pool.get()) Ite(1, 1, 2, one, one));
+  void* memory = first.get();
+  first.reset();
+  ItePtr second(new (pool.get()) Ite(2, 2, 3, one, one));
+  EXPECT_EQ(memory, second.get());
+  EXPECT_EQ(2, pool->stats().allocations);
+  EXPECT_EQ(1, pool->stats().reuses);
+  EXPECT_EQ(1, pool->stats().max_live);
+  EXPECT_EQ(1, pool->stats().slabs);
+}
+
+// The vertices outliving their manager keep the orphaned pool alive.
+TEST(VertexPoolTest, Orphan) {
+  const int kNumVertices = 2000;  // Multiple slabs.
+  IntrusivePtr<Vertex<Ite>> one(new Terminal<Ite>(true));
+  std::vector<ItePtr> vertices;
+  {
+    auto pool = VertexPool<Ite>::Create();
+    for (int i = 0; i < kNumVertices; ++i)
+      vertices.emplace_back(new (pool.get()) Ite(i, i, i + 2, one, one));
+    EXPECT_LT(1, pool->stats().slabs);
+  }
+  for (int i = 0; i < kNumVertices; ++i) {
+    EXPECT_EQ(i, vertices[i]->index());
+    EXPECT_EQ(one, vertices[i]->high());
+  }
+  vertices.clear();  // The last vertex releases the pool.
+}
+
 // Tests the performance of probability calculations.
 TEST_F(PerformanceTest, DISABLED_ThreeMotor) {
   double p_time_std = 0.01;
@@ -17,13 +17,20 @@
 
 #include "risk_analysis_tests.h"
 
+#include <fstream>
 #include <utility>
+#include <variant>
 
 #include "utility.h"
 
 #include "env.h"
 #include "error.h"
+#include "bdd.h"
+#include "expression/constant.h"
+#include "fault_tree_analysis.h"
 #include "initializer.h"
+#include "parameter.h"
+#include "probability_analysis.h"
 #include "reporter.h"
 #include "xml.h"
 
@@ -114,6 +121,13 @@ std::map<std::string, double> RiskAnalysisTest::sequences() {
   return results;
 }
 
+std::string RiskAnalysisTest::GetTargetName(
+    const RiskAnalysis::Result& result) {
+  if (auto* sequence = std::get_if<1>(&result.id.target))
+    return sequence->second.name();
+  return std::get<const mef::Gate*>(result.id.target)->id();
+}
+
 std::set<std::string> RiskAnalysisTest::Convert(const Product& product) {
   std::set<std::string> string_set;
   for (const Literal& literal : product) {
@@ -318,6 +332,51 @@ TEST_F(RiskAnalysisTest, ImportanceRareEvent) {
                   {"ValveTwo", {2, 0.1, 0.4167, 0.4458, 8.917, 1.714}}});
 }
 
+// The factors from the single-pass calculations for all variables
+// must match the differences of the conditional probabilities.
+TEST_F(RiskAnalysisTest, ImportanceConditional) {
+  std::vector<std::vector<std::string>> inputs = {
+      {"tests/input/fta/correct_non_coherent.xml"},
+      {"tests/input/fta/importance_neg_test.xml"},
+      {"tests/input/fta/importance_test.xml"},
+      {"input/ThreeMotor/three_motor.xml"},
+      {"input/Theatre/theatre.xml"}};
+  mef::ConstantExpression one(1);
+  mef::ConstantExpression zero(0);
+  for (const char* approximation : {"none", "rare-event", "mcub"}) {
+    bool exact = approximation == std::string("none");
+    for (const auto& input : inputs) {
+      settings.prime_implicants(false)
+          .approximation(approximation)
+          .prime_implicants(exact)
+          .importance_analysis(true);
+      ASSERT_NO_THROW(ProcessInputFiles(input));
+      ASSERT_NO_THROW(analysis->Analyze());
+      ASSERT_EQ(1, analysis->results().size());
+      core::Settings reference_settings = settings;
+      reference_settings.importance_analysis(false);
+      auto p_conditional = [this, &reference_settings](mef::BasicEvent& event,
+                                                       mef::Expression* state) {
+        mef::Expression& init_expression = event.expression();
+        event.expression(state);
+        RiskAnalysis reference(model.get(), reference_settings);
+        reference.Analyze();
+        event.expression(&init_expression);
+        return reference.results().front().probability_analysis->p_total();
+      };
+      const auto& importance =
+          analysis->results().front().importance_analysis->importance();
+      ASSERT_FALSE(importance.empty());
+      for (int i = 0; i < importance.size(); ++i) {
+        auto& event = const_cast<mef::BasicEvent&>(importance[i].event);
+        double mif = p_conditional(event, &one) - p_conditional(event, &zero);
+        EXPECT_NEAR(mif, importance[i].factors.mif, 1e-9 + 1e-9 * std::abs(mif))
+            << approximation << ": " << input.front() << ": " << event.id();
+      }
+    }
+  }
+}
+
 // Apply the minimal cut set upper bound approximation.
 TEST_F(RiskAnalysisTest, Mcub) {
   std::string with_prob = "tests/input/fta/correct_tree_input_with_probs.xml";
@@ -328,6 +387,20 @@ TEST_F(RiskAnalysisTest, Mcub) {
   EXPECT_DOUBLE_EQ(0.766144, p_total());
 }
 
+// The compiled products must reproduce the reference MCUB probability.
+TEST_F(RiskAnalysisTest, FlatProductsMcub) {
+  std::string tree_input = "tests/input/fta/correct_tree_input_with_probs.xml";
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  FaultTreeAnalyzer<Bdd> fta(*gates().find("TopEvent")->get(), settings);
+  fta.Analyze();
+  FlatProducts flat_products(fta.products().zbdd());
+  Pdag::IndexMap<double> p_vars;
+  for (const mef::BasicEvent* event : fta.graph()->basic_events())
+    p_vars.push_back(event->p());
+  EXPECT_NEAR(0.766144, McubCalculator().Calculate(flat_products, p_vars),
+              1e-6);
+}
+
 // Apply the minimal cut set upper bound approximation for non-coherent tree.
 // This should be a warning.
 TEST_F(RiskAnalysisTest, McubNonCoherent) {
@@ -374,6 +447,30 @@ TEST_P(RiskAnalysisTest, AnalyzeProbabilityOverTime) {
   ASSERT_TRUE(time);
 }
 
+// The batched time points must match the analyses at the mission time.
+TEST_P(RiskAnalysisTest, AnalyzeProbabilityOverTimeBatches) {
+  std::string tree_input = "input/BSCU/BSCU.xml";
+  settings.probability_analysis(true).time_step(500).mission_time(8760);
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  ASSERT_NO_THROW(analysis->Analyze());
+  ASSERT_FALSE(analysis->results().empty());
+  std::vector<std::pair<double, double>> p_time =
+      analysis->results().front().probability_analysis->p_time();
+  ASSERT_EQ(19, p_time.size());
+  EXPECT_DOUBLE_EQ(p_total(), p_time.back().first);
+  EXPECT_LT(p_time.front().first, p_time.back().first);
+  for (int i : {0, 7, 8, 9, 17}) {
+    Settings point_settings = settings;
+    point_settings.time_step(0).mission_time(p_time[i].second);
+    model->mission_time().value(p_time[i].second);
+    RiskAnalysis reference(model.get(), point_settings);
+    reference.Analyze();
+    EXPECT_NEAR(reference.results().front().probability_analysis->p_total(),
+                p_time[i].first, 1e-12)
+        << p_time[i].second;
+  }
+}
+
 TEST_P(RiskAnalysisTest, AnalyzeSil) {
   std::string tree_input = "tests/input/core/single_exponential.xml";
   settings.time_step(24).safety_integrity_levels(true);
@@ -486,6 +583,13 @@ TEST_F(RiskAnalysisTest, ReportProbability) {
   CheckReport({tree_input});
 }
 
+// Reporting of the truncated products with the cut-off probability.
+TEST_P(RiskAnalysisTest, ReportCutOff) {
+  std::string tree_input = "tests/input/fta/correct_tree_input_with_probs.xml";
+  settings.cut_off(0.1);
+  CheckReport({tree_input});
+}
+
 TEST_F(RiskAnalysisTest, ReportProbabilityCurve) {
   std::string tree_input = "tests/input/core/single_exponential.xml";
   settings.probability_analysis(true).time_step(24).mission_time(720);
@@ -629,4 +733,131 @@ TEST_P(RiskAnalysisTest, ExternFunctionProbability) {
   EXPECT_DOUBLE_EQ(0.1, p_total());
 }
 
+// Re-quantification with changed values must match the full re-analysis.
+TEST_P(RiskAnalysisTest, Requantify) {
+  std::string tree_input = "input/BSCU/BSCU.xml";
+  settings.importance_analysis(true).time_step(100).safety_integrity_levels(
+      true);
+  ASSERT_NO_THROW(ProcessInputFiles({tree_input}));
+  ASSERT_NO_THROW(analysis->Analyze());
+  ASSERT_FALSE(analysis->results().empty());
+  double p_init = analysis->results().front().probability_analysis->p_total();
+
+  mef::ConstantExpression rate(1e-4);
+  mef::ConstantExpression probability(0.25);
+  mef::Parameter& parameter =
+      **model->parameters().find("FailureRateSwitchStuck");
+  mef::BasicEvent& event = **basic_events().begin();
+  mef::Expression* init_rate = parameter.ReplaceExpression(&rate);
+  mef::Expression& init_probability = event.expression();
+  event.expression(&probability);
+  analysis->Requantify();
+
+  RiskAnalysis reference(model.get(), settings);
+  reference.Analyze();
+  ASSERT_EQ(reference.results().size(), analysis->results().size());
+  for (int i = 0; i < analysis->results().size(); ++i) {
+    const auto& result = analysis->results()[i];
+    const auto& expected = reference.results()[i];
+    EXPECT_DOUBLE_EQ(expected.probability_analysis->p_total(),
+                     result.probability_analysis->p_total());
+    EXPECT_DOUBLE_EQ(expected.probability_analysis->sil().pfd_avg,
+                     result.probability_analysis->sil().pfd_avg);
+    EXPECT_DOUBLE_EQ(expected.probability_analysis->sil().pfh_avg,
+                     result.probability_analysis->sil().pfh_avg);
+    const auto& importance = result.importance_analysis->importance();
+    const auto& expected_importance =
+        expected.importance_analysis->importance();
+    ASSERT_EQ(expected_importance.size(), importance.size());
+    for (int j = 0; j < importance.size(); ++j) {
+      EXPECT_EQ(&expected_importance[j].event, &importance[j].event);
+      EXPECT_DOUBLE_EQ(expected_importance[j].factors.mif,
+                       importance[j].factors.mif);
+      EXPECT_DOUBLE_EQ(expected_importance[j].factors.raw,
+                       importance[j].factors.raw);
+    }
+  }
+  EXPECT_NE(p_init,
+            analysis->results().front().probability_analysis->p_total());
+
+  parameter.ReplaceExpression(init_rate);
+  event.expression(&init_probability);
+  analysis->Requantify();
+  EXPECT_DOUBLE_EQ(p_init,
+                   analysis->results().front().probability_analysis->p_total());
+}
+
+// The analysis with a cached preprocessed PDAG must match the fresh one.
+TEST_P(RiskAnalysisTest, PdagCache) {
+  std::vector<std::vector<std::string>> inputs = {
+      {"tests/input/fta/correct_tree_input_with_probs.xml"},
+      {"tests/input/fta/correct_non_coherent.xml"},
+      {"tests/input/fta/constant_propagation.xml"},
+      {"input/ThreeMotor/three_motor.xml"},
+      {"input/Baobab/baobab1.xml", "input/Baobab/baobab1-basic-events.xml"}};
+  fs::path cache_dir = utility::GenerateFilePath();
+  settings.probability_analysis(true);
+  for (const auto& input : inputs) {
+    settings.cache_dir("");
+    ASSERT_NO_THROW(ProcessInputFiles(input));
+    ASSERT_NO_THROW(analysis->Analyze());
+    std::set<std::set<std::string>> expected_products = products();
+    double expected_p_total = p_total();
+
+    settings.cache_dir(cache_dir.string());
+    for (int run = 0; run < 2; ++run) {  // Store and load.
+      ASSERT_NO_THROW(ProcessInputFiles(input));
+      ASSERT_NO_THROW(analysis->Analyze());
+      EXPECT_EQ(expected_products, products()) << input.front();
+      EXPECT_NEAR(expected_p_total, p_total(), 1e-12 * expected_p_total)
+          << input.front();
+    }
+  }
+  EXPECT_EQ(inputs.size(), std::distance(fs::directory_iterator(cache_dir),
+                                         fs::directory_iterator()));
+  fs::remove_all(cache_dir);
+}
+
+// A cache entry of another graph under the same hash must be rejected.
+TEST_F(RiskAnalysisTest, PdagCacheCollision) {
+  std::vector<std::string> input_one = {
+      "tests/input/fta/correct_tree_input_with_probs.xml"};
+  std::vector<std::string> input_two = {
+      "tests/input/fta/correct_non_coherent.xml"};
+  fs::path cache_dir = utility::GenerateFilePath();
+  ASSERT_NO_THROW(ProcessInputFiles(input_two));
+  ASSERT_NO_THROW(analysis->Analyze());
+  std::set<std::set<std::string>> expected_products = products();
+
+  settings.cache_dir(cache_dir.string());
+  ASSERT_NO_THROW(ProcessInputFiles(input_one));
+  ASSERT_NO_THROW(analysis->Analyze());
+  fs::path entry_one = fs::directory_iterator(cache_dir)->path();
+  ASSERT_NO_THROW(ProcessInputFiles(input_two));
+  ASSERT_NO_THROW(analysis->Analyze());
+  fs::path entry_two;
+  for (const fs::directory_entry& entry : fs::directory_iterator(cache_dir)) {
+    if (entry.path() != entry_one)
+      entry_two = entry.path();
+  }
+  ASSERT_FALSE(entry_two.empty());
+
+  // Forge the collision with the other graph under the key of this graph.
+  const int key_offset = 16;  // After the signature, version, and flags.
+  char key[8];
+  std::ifstream(entry_two.string(), std::ios::binary)
+      .seekg(key_offset)
+      .read(key, sizeof(key));
+  fs::copy_file(entry_one, entry_two, fs::copy_option::overwrite_if_exists);
+  std::fstream(entry_two.string(),
+               std::ios::binary | std::ios::in | std::ios::out)
+      .seekp(key_offset)
+      .write(key, sizeof(key));
+
+  ASSERT_NO_THROW(ProcessInputFiles(input_two));
+  ASSERT_NO_THROW(analysis->Analyze());
+  EXPECT_EQ(expected_products, products());
+  fs::remove_all(cache_dir);
+}
+
 }  // namespace scram::core::test
@@ -123,6 +123,10 @@ class RiskAnalysisTest : public ::testing::TestWithParam<const char*> {
   /// @returns The event-tree analysis sequence results.
   std::map<std::string, double> sequences();
 
+  /// @returns The name of the sequence or the id of the gate
+  ///          as the analysis target of the result.
+  static std::string GetTargetName(const RiskAnalysis::Result& result);
+
   // Members
   std::unique_ptr<RiskAnalysis> analysis;
   std::shared_ptr<mef::Model> model;
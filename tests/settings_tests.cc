@@ -29,8 +29,21 @@ TEST(SettingsTest, IncorrectSetup) {
   EXPECT_THROW(s.algorithm("the-best"), SettingsError);
   // Incorrect approximation argument.
   EXPECT_THROW(s.approximation("approx"), SettingsError);
+  // Incorrect variable ordering heuristic.
+  EXPECT_THROW(s.variable_order("random"), SettingsError);
+  // The variable ordering heuristics inappropriate for the algorithm.
+  s.algorithm("zbdd");
+  EXPECT_THROW(s.variable_order("tournament"), SettingsError);
+  s.algorithm("mocus");
+  EXPECT_THROW(s.variable_order("force"), SettingsError);
+  EXPECT_THROW(s.variable_order("fan-in"), SettingsError);
+  EXPECT_THROW(s.variable_order("tournament"), SettingsError);
+  EXPECT_NO_THROW(s.variable_order("dfs"));
+  s.algorithm("bdd");
   // Incorrect limit order for products.
   EXPECT_THROW(s.limit_order(-1), SettingsError);
+  // Incorrect number of top products.
+  EXPECT_THROW(s.top_products(-1), SettingsError);
   // Incorrect cut-off probability.
   EXPECT_THROW(s.cut_off(-1), SettingsError);
   EXPECT_THROW(s.cut_off(10), SettingsError);
@@ -45,6 +58,11 @@ TEST(SettingsTest, IncorrectSetup) {
   EXPECT_THROW(s.num_bins(0), SettingsError);
   // Incorrect seed.
   EXPECT_THROW(s.seed(-1), SettingsError);
+  // Incorrect number of jobs.
+  EXPECT_THROW(s.jobs(-1), SettingsError);
+  EXPECT_THROW(s.jobs(0), SettingsError);
+  // Incorrect reordering time.
+  EXPECT_THROW(s.reorder_time(-1), SettingsError);
   // Incorrect mission time.
   EXPECT_THROW(s.mission_time(-10), SettingsError);
   // Incorrect time step.
@@ -68,13 +86,42 @@ TEST(SettingsTest, CorrectSetup) {
   EXPECT_NO_THROW(s.approximation("rare-event"));
   EXPECT_NO_THROW(s.approximation("mcub"));
 
+  // Correct variable ordering heuristic.
+  EXPECT_NO_THROW(s.variable_order("dfs"));
+  EXPECT_NO_THROW(s.variable_order("force"));
+  EXPECT_NO_THROW(s.variable_order("fan-in"));
+  {
+    Settings bdd_settings;
+    EXPECT_NO_THROW(bdd_settings.variable_order("tournament"));
+    bdd_settings.algorithm("zbdd");  // Falls back to the default order.
+    EXPECT_EQ(VariableOrder::kDfs, bdd_settings.variable_order());
+    EXPECT_NO_THROW(bdd_settings.variable_order("force"));
+    bdd_settings.algorithm("mocus");
+    EXPECT_EQ(VariableOrder::kDfs, bdd_settings.variable_order());
+  }
+
   // Correct limit order for products.
   EXPECT_NO_THROW(s.limit_order(1));
   EXPECT_NO_THROW(s.limit_order(32));
   EXPECT_NO_THROW(s.limit_order(1e9));
 
+  // Correct number of top products.
+  EXPECT_NO_THROW(s.top_products(0));
+  EXPECT_FALSE(s.probability_analysis());
+  EXPECT_NO_THROW(s.top_products(1000));
+  EXPECT_TRUE(s.probability_analysis());
+  s.probability_analysis(false);  // Required by the top products.
+  EXPECT_TRUE(s.probability_analysis());
+  EXPECT_NO_THROW(s.top_products(0));
+
   // Correct cut-off probability.
+  EXPECT_NO_THROW(s.cut_off(0));
+  s.probability_analysis(false);
+  EXPECT_FALSE(s.probability_analysis());
   EXPECT_NO_THROW(s.cut_off(1));
+  EXPECT_TRUE(s.probability_analysis());
+  s.probability_analysis(false);  // Required by the cut-off.
+  EXPECT_TRUE(s.probability_analysis());
   EXPECT_NO_THROW(s.cut_off(0));
   EXPECT_NO_THROW(s.cut_off(0.5));
 
@@ -93,6 +140,13 @@ TEST(SettingsTest, CorrectSetup) {
   // Correct seed.
   EXPECT_NO_THROW(s.seed(1));
 
+  // Correct number of jobs.
+  EXPECT_NO_THROW(s.jobs(1));
+  EXPECT_NO_THROW(s.jobs(64));
+  // Correct reordering time.
+  EXPECT_NO_THROW(s.reorder_time(0));
+  EXPECT_NO_THROW(s.reorder_time(2.5));
+
   // Correct mission time.
   EXPECT_NO_THROW(s.mission_time(0));
   EXPECT_NO_THROW(s.mission_time(10));
@@ -122,4 +176,18 @@ TEST(SettingsTest, SetupForPrimeImplicants) {
   EXPECT_THROW(s.approximation("mcub"), SettingsError);
 }
 
+TEST(SettingsTest, SetupForSharedSequences) {
+  Settings s;
+  // Incorrect request for the shared analysis.
+  EXPECT_NO_THROW(s.algorithm("zbdd"));
+  EXPECT_THROW(s.shared_sequences(true), SettingsError);
+  // Correct request for the shared analysis.
+  ASSERT_NO_THROW(s.algorithm("bdd"));
+  ASSERT_NO_THROW(s.shared_sequences(true));
+  EXPECT_TRUE(s.shared_sequences());
+  // The change of the algorithm cancels the request.
+  ASSERT_NO_THROW(s.algorithm("mocus"));
+  EXPECT_FALSE(s.shared_sequences());
+}
+
 }  // namespace scram::core::test
@@ -66,6 +66,8 @@ def test_fta_no_prob(tmpdir):
         # Test the incorrect cut-off probability
         (["--cut-off", "-1"], False),
         (["--cut-off", "10"], False),
+        # Test the re-quantification of products truncated by the cut-off
+        (["--cut-off", "1e-3", "--what-if", "PumpOne=0.5"], False),
         # Test conflicting algorithms
         (["--zbdd", "--bdd"], False),
         # Test the application of the rare event and MCUB at the same time
@@ -80,7 +82,11 @@ def test_fta_no_prob(tmpdir):
         # Test calls for prime implicants
         (["--prime-implicants", "--mocus"], False),
         (["--prime-implicants", "--rare-event"], False),
-        (["--prime-implicants", "--mcub"], False)
+        (["--prime-implicants", "--mcub"], False),
+        # Test the variable ordering heuristics inappropriate for algorithms
+        (["--mocus", "--variable-order", "force"], False),
+        (["--zbdd", "--variable-order", "tournament"], False),
+        (["--zbdd", "--variable-order", "fan-in"], True)
     ])
 def test_fta_calls(cmd, status):
     """Tests calls for full fault tree analysis."""